@@ -4,20 +4,228 @@
 #ifndef ARGSPLUS_HXX
 #define ARGSPLUS_HXX
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
 #include <initializer_list>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <locale>
 #include <memory>
 #include <sstream>
 #include <string>
 #include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
+// Response files are memory-mapped where POSIX mmap is available, unless
+// ARGSPLUS_NO_MMAP is defined, and read into a buffer otherwise
+#if !defined(ARGSPLUS_NO_MMAP) && (defined(__unix__) || defined(__APPLE__))
+#define ARGSPLUS_HAVE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Floats are converted with strtod_l() in the "C" locale where the C library
+// has it, so that setlocale() can't change the decimal point they accept, and
+// otherwise with strtod() while the C locale's decimal point is "."
+#if !defined(ARGSPLUS_NO_STRTOD_L) &&                                          \
+    (defined(__GLIBC__) || defined(__APPLE__) || defined(__FreeBSD__))
+#define ARGSPLUS_HAVE_STRTOD_L
+#include <locale.h>
+#if defined(__APPLE__) || defined(__FreeBSD__)
+#include <xlocale.h>
+#endif
+#else
+#include <clocale>
+#endif
+
+// The Tokenizer scans bytes a block at a time with whichever of AVX2, SSE2,
+// and AArch64 NEON the compiler targets, unless ARGSPLUS_NO_SIMD is defined
+#ifndef ARGSPLUS_NO_SIMD
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+#endif
+
+// Parsers count and time what they do into an attached Stats only when
+// ARGSPLUS_INSTRUMENT is defined, and the probes are compiled out otherwise
+#ifdef ARGSPLUS_INSTRUMENT
+#define ARGSPLUS_INSTRUMENTED true
+#if defined(__x86_64__) || defined(__i386__)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define ARGSPLUS_HAVE_RDTSC
+#endif
+#else
+#define ARGSPLUS_INSTRUMENTED false
+#endif
+
 namespace argsplus {
 template <typename String = std::string, typename Char = char,
     template <typename...> class List = std::vector,
-    template <typename...> class Set = std::unordered_set>
+    template <typename...> class Set = std::unordered_set,
+    template <typename...> class Map = std::unordered_map,
+    template <typename...> class Allocator = std::allocator>
 class ArgumentParser {
+    public:
+    /** A non-owning view of a run of characters.
+     *
+     * The parser examines and splits argument chunks through views, so that
+     * nothing is copied unless a value's parser asks for an owning String.
+     * The viewed characters must outlive the view.
+     */
+    class StringView {
+        private:
+        const Char *_data;
+        std::size_t _size;
+
+        public:
+        static const std::size_t npos = static_cast<std::size_t>(-1);
+
+        StringView() : _data(nullptr), _size(0) {}
+        StringView(const Char *data, const std::size_t size)
+            : _data(data), _size(size) {}
+        StringView(const Char *data)
+            : _data(data), _size(std::char_traits<Char>::length(data)) {}
+        StringView(const String &string)
+            : _data(string.data()), _size(string.size()) {}
+
+        const Char *data() const { return _data; }
+        std::size_t size() const { return _size; }
+        bool empty() const { return _size == 0; }
+        const Char *begin() const { return _data; }
+        const Char *end() const { return _data + _size; }
+        const Char &operator[](const std::size_t pos) const {
+            return _data[pos];
+        }
+
+        /** Get a subview, clamped to the end of this view like
+         * std::basic_string::substr
+         */
+        StringView substr(
+            const std::size_t pos, const std::size_t count = npos) const {
+            const std::size_t start = pos < _size ? pos : _size;
+            const std::size_t rest = _size - start;
+            return StringView(_data + start, count < rest ? count : rest);
+        }
+
+        std::size_t find(const StringView &needle) const {
+            const Char *found = std::search(begin(), end(), needle.begin(),
+                needle.end());
+            return found == end() && !needle.empty()
+                ? npos
+                : static_cast<std::size_t>(found - _data);
+        }
+
+        bool StartsWith(const StringView &prefix) const {
+            return prefix._size <= _size &&
+                std::char_traits<Char>::compare(
+                    _data, prefix._data, prefix._size) == 0;
+        }
+
+        /** Materialize an owning copy of the viewed characters
+         */
+        String str() const { return String(_data, _size); }
+
+        friend bool operator==(const StringView &lhs, const StringView &rhs) {
+            return lhs._size == rhs._size &&
+                std::char_traits<Char>::compare(
+                    lhs._data, rhs._data, lhs._size) == 0;
+        }
+
+        friend bool operator!=(const StringView &lhs, const StringView &rhs) {
+            return !(lhs == rhs);
+        }
+
+        /** FNV-1a hash, for keying hashed containers by views
+         */
+        struct Hash {
+            std::size_t operator()(const StringView &view) const {
+                std::size_t hash = static_cast<std::size_t>(2166136261u);
+                for (const Char c : view) {
+                    hash ^= static_cast<std::size_t>(c);
+                    hash *= static_cast<std::size_t>(16777619u);
+                }
+                return hash;
+            }
+        };
+    };
+
+    /** A function that converts a value of type T from a view of its
+     * characters, into the existing value in place of ExtractValue.
+     *
+     * The existing value is in whatever state the last conversion or reset
+     * left it, so that a converter can build a fresh value and move it in,
+     * append to a list, or reuse its storage.  It returns whether the value
+     * was valid.
+     *
+     * Any callable that is trivially copyable and fits in Capacity bytes,
+     * like a function pointer or a lambda capturing a few pointers or
+     * numbers, is held inline, so that a Converter never allocates, and is
+     * called through a single function pointer.
+     */
+    template <typename T>
+    class Converter {
+        public:
+        static const std::size_t Capacity = 4 * sizeof(void *);
+
+        private:
+        using Invoke = bool (*)(const void *, const StringView &, T &);
+
+        typename std::aligned_storage<Capacity,
+            alignof(std::max_align_t)>::type _storage;
+        Invoke _invoke;
+
+        template <typename F>
+        static bool Call(
+            const void *function, const StringView &value, T &out) {
+            return (*static_cast<const F *>(function))(value, out);
+        }
+
+        public:
+        Converter() : _invoke(nullptr) {}
+        Converter(std::nullptr_t) : _invoke(nullptr) {}
+
+        template <typename F,
+            typename = typename std::enable_if<
+                !std::is_same<F, Converter>::value>::type>
+        Converter(F function) : _invoke(&Call<F>) {
+            static_assert(sizeof(F) <= Capacity &&
+                    alignof(F) <= alignof(std::max_align_t),
+                "converters must fit in Converter::Capacity");
+            static_assert(std::is_trivially_copyable<F>::value,
+                "converters must be trivially copyable");
+            new (&_storage) F(function);
+        }
+
+        explicit operator bool() const { return _invoke != nullptr; }
+
+        bool operator()(const StringView &value, T &out) const {
+            return _invoke(&_storage, value, out);
+        }
+    };
+
     private:
     /** A simple unified option type for unified initializer lists for the
      * Matcher class.
@@ -25,7 +233,8 @@ class ArgumentParser {
     struct EitherFlag {
         const bool isShort;
         const Char shortFlag;
-        const String longFlag;
+        // A view of the argument, which lives as long as the initializer list
+        const StringView longFlag;
         EitherFlag(const String &flag)
             : isShort(false), shortFlag(), longFlag(flag) {}
         EitherFlag(const Char *flag)
@@ -39,7 +248,8 @@ class ArgumentParser {
             Set<String> longFlags;
             for (const EitherFlag &flag : flags) {
                 if (!flag.isShort) {
-                    longFlags.insert(flag.longFlag);
+                    longFlags.insert(
+                        String(flag.longFlag.data(), flag.longFlag.size()));
                 }
             }
             return longFlags;
@@ -113,36 +323,138 @@ class ArgumentParser {
         bool Match(const String &flag) const {
             return _long_flags.find(flag) != std::end(_long_flags);
         }
+
+        const Set<Char> &ShortFlags() const { return _short_flags; }
+        const Set<String> &LongFlags() const { return _long_flags; }
+    };
+
+    /** The flags that an option is added with: a Matcher, or the initializer
+     * list that would make one, which is read without building its Sets.
+     * Either is only viewed, for as long as the call that adds the option.
+     */
+    class FlagSource {
+        private:
+        const Matcher *_matcher;
+        std::initializer_list<EitherFlag> _flags;
+
+        public:
+        FlagSource(const Matcher &matcher) : _matcher(&matcher) {}
+        FlagSource(std::initializer_list<EitherFlag> flags)
+            : _matcher(nullptr), _flags(flags) {}
+
+        /** Call onShort with every short flag, and onLong with a view of
+         * every long flag, which may repeat if the list does
+         */
+        template <typename Short, typename Long>
+        void ForEach(const Short &onShort, const Long &onLong) const {
+            if (_matcher) {
+                for (const Char flag : _matcher->ShortFlags()) {
+                    onShort(flag);
+                }
+                for (const String &flag : _matcher->LongFlags()) {
+                    onLong(StringView(flag));
+                }
+                return;
+            }
+            for (const EitherFlag &flag : _flags) {
+                if (flag.isShort) {
+                    onShort(flag.shortFlag);
+                } else {
+                    onLong(flag.longFlag);
+                }
+            }
+        }
+    };
+
+    /** The flags of an option, copied into the parser's arena as it is added,
+     * each of them once
+     */
+    struct Flags {
+        StringView shorts;
+        const StringView *longs;
+        std::size_t longCount;
     };
 
+    class Arena;
+
     // This is necessary because all template types need to be stored in the
     // same container.
     class Root {
         protected:
-        String _name;
-        String _help;
+        // Copies in the parser's arena, which are replaced rather than freed
+        // when they are set again
+        StringView _name;
+        StringView _help;
+        // Where the parser's arena is, which follows it when the parser moves
+        Arena *const *_arena;
         bool _matched;
+        std::size_t _slot;
+        // Once the parser is frozen, whether the node is matched is a bit of
+        // the parser's bitset instead, so that marking and resetting matches
+        // skips the node; its value is still converted into the node
+        std::uint64_t *_bits;
+        // Set when the name or help changes, so that the parser renders its
+        // help again
+        bool *_changed;
 
         Root(const Root &) = delete;
         Root &operator=(const Root &) = delete;
 
+        void Changed() {
+            if (_changed) {
+                *_changed = true;
+            }
+        }
+
         public:
-        Root(const String &name) : _name(name), _matched(false) {}
+        Root(Arena *const *arena, const StringView &name)
+            : _name((*arena)->Copy(name)),
+              _arena(arena),
+              _matched(false),
+              _slot(0),
+              _bits(nullptr),
+              _changed(nullptr) {}
         Root(Root &&other) = default;
         Root &operator=(Root &&) = default;
         virtual ~Root() = default;
 
-        const String &Name() const { return _name; }
-        const String &Help() const { return _help; }
-        bool Matched() const { return _matched; }
-        void SetName(const String &name) {
-            _name = name;
+        StringView Name() const { return _name; }
+        StringView Help() const { return _help; }
+        bool Matched() const {
+            return _bits ? (_bits[_slot / 64] >> (_slot % 64) & 1) != 0
+                         : _matched;
+        }
+        /** The position of this node in its parser, which identifies its
+         * value in a Result
+         */
+        std::size_t Slot() const { return _slot; }
+        void SetSlot(const std::size_t slot) {
+            _slot = slot;
+        }
+        void SetName(const StringView &name) {
+            _name = (*_arena)->Copy(name);
+            Changed();
+        }
+        void SetHelp(const StringView &help) {
+            _help = (*_arena)->Copy(help);
+            Changed();
         }
-        void SetHelp(const String &help) {
-            _help = help;
+        void SetChanged(bool *changed) {
+            _changed = changed;
         }
         void SetMatched(const bool matched) {
-            _matched = matched;
+            if (_bits) {
+                std::uint64_t &word = _bits[_slot / 64];
+                const std::uint64_t bit = std::uint64_t(1) << (_slot % 64);
+                word = matched ? word | bit : word & ~bit;
+            } else {
+                _matched = matched;
+            }
+        }
+        void SetBits(std::uint64_t *bits) {
+            _matched = Matched();
+            _bits = bits;
+            SetMatched(_matched);
         }
     };
 
@@ -155,47 +467,59 @@ class ArgumentParser {
         Base &operator=(const Base &) = delete;
 
         public:
-        Base(const String &name) : Root(name) {}
+        Base(Arena *const *arena, const StringView &name)
+            : Root(arena, name) {}
+
+        // Keep the getters visible next to the chaining setters
+        using Root::Name;
+        using Root::Help;
+        using Root::Matched;
 
         Base(Base &&other) = default;
         Base &operator=(Base &&) = default;
         virtual ~Base() = default;
 
-        OptionType &Name(const String &name) {
-            Root::_name = name;
+        OptionType &Name(const StringView &name) {
+            Root::SetName(name);
             return *static_cast<OptionType *>(this);
         }
 
-        OptionType &Help(const String &help) {
-            Root::_help = help;
+        OptionType &Help(const StringView &help) {
+            Root::SetHelp(help);
             return *static_cast<OptionType *>(this);
         }
 
         OptionType &Matched(bool matched) {
-            Root::_matched = matched;
+            Root::SetMatched(matched);
             return *static_cast<OptionType *>(this);
         }
     };
 
     class OptionBase {
         private:
-        const Matcher _matcher;
+        const Flags _flags;
 
         OptionBase(const OptionBase &) = delete;
         OptionBase &operator=(const OptionBase &) = delete;
 
         public:
-        OptionBase(Matcher &&matcher)
-            : _matcher(std::move(matcher)) {}
+        OptionBase(const Flags &flags) : _flags(flags) {}
 
         OptionBase(OptionBase &&other) = default;
         OptionBase &operator=(OptionBase &&) = default;
         virtual ~OptionBase() = default;
 
-        template <typename T>
-        bool Match(const T &flag) const {
-            return _matcher.Match(flag);
-        }
+        const Flags &GetFlags() const { return _flags; }
+    };
+
+    /** Where a value came from: the index of its chunk in the parsed
+     * arguments, a view of the value itself, and the flag it was passed
+     * through, which is empty for positionals
+     */
+    struct Span {
+        std::size_t index;
+        StringView value;
+        StringView flag;
     };
 
     // This is necessary because we need to be able to get a positional or
@@ -211,363 +535,4972 @@ class ArgumentParser {
         ValueRoot(ValueRoot &&other) = default;
         ValueRoot &operator=(ValueRoot &&) = default;
         virtual ~ValueRoot() = default;
-        virtual bool ParseValue(const String &value) = 0;
-    };
-
-    template <typename OptionType, typename ValueType>
-    class ValueBase : public ValueRoot {
-        private:
-        ValueBase(const ValueBase &) = delete;
-        ValueBase &operator=(const ValueBase &) = delete;
-        ValueType _value;
-
-        public:
-        ValueBase() = default;
-        ValueBase(ValueBase &&other) = default;
-        ValueBase &operator=(ValueBase &&) = default;
-        virtual ~ValueBase() = default;
-
-        virtual bool ParseValue(const String &value) {
-            std::basic_istringstream<Char> ss(value);
-            ss >> _value;
-            if (ss.rdbuf()->in_avail() > 0 || ss.fail()) {
-                return false;
-            }
-            return true;
-        }
-
-        const ValueType &Default() const { return _value; }
-
-        OptionType &Default(const ValueType &defaultvalue) {
-            _value = defaultvalue;
-            return *static_cast<OptionType *>(this);
-        }
-        const ValueType &Value() const { return _value; }
+        virtual bool ParseValue(const StringView &value) = 0;
+        virtual void Reset() = 0;
+        // Whether a Converter is set
+        virtual bool Converts() const = 0;
 
-        OptionType &Value(const ValueType &value) {
-            _value = value;
-            return *static_cast<OptionType *>(this);
-        }
-    };
-
-    template <typename Type>
-    class Option :
-        public Base<Option<Type>>,
-        public OptionBase,
-        public ValueBase<Option<Type>, Type>
-    {
-        private:
-        using BaseType = Base<Option<Type>>;
-        Option(const Option &) = delete;
-        Option &operator=(const Option &) = delete;
+        // Record a value to convert on first access, which replaces any
+        // recorded before it unless the value is a list
+        virtual void Defer(const Span &span) = 0;
+        // Convert every deferred value, giving the first that fails
+        virtual bool Resolve(Span &failed) const = 0;
+        // Split the deferred values into at most the given number of pieces
+        // that convert independently, convert a piece, giving the first that
+        // fails, and join the given number of converted pieces back in order
+        virtual std::size_t SplitDeferred(std::size_t most) const = 0;
+        virtual bool ResolvePiece(std::size_t piece, Span &failed) const = 0;
+        virtual void JoinPieces(std::size_t pieces) const = 0;
 
-        public:
-        Option(const String &name, Matcher &&matcher)
-            : BaseType(name), OptionBase(std::move(matcher)) {}
+        // Manage a copy of the value that lives in a Result instead
+        virtual std::size_t SlotSize() const = 0;
+        virtual std::size_t SlotAlignment() const = 0;
+        virtual void ConstructSlot(void *slot) const = 0;
+        virtual void ResetSlot(void *slot) const = 0;
+        virtual void DestroySlot(void *slot) const = 0;
+        virtual bool ParseSlot(void *slot, const StringView &value) const = 0;
 
-        Option(Option &&other) = default;
-        Option &operator=(Option &&) = default;
-        virtual ~Option() = default;
+        // Manage a List of values, one per record, that lives in a Batch
+        virtual std::size_t ColumnSize() const = 0;
+        virtual std::size_t ColumnAlignment() const = 0;
+        virtual void ConstructColumn(void *column) const = 0;
+        virtual void DestroyColumn(void *column) const = 0;
+        virtual void ResizeColumn(void *column, std::size_t size) const = 0;
+        virtual void StoreColumn(
+            void *column, std::size_t row, void *slot) const = 0;
     };
 
-    template <typename Type>
-    class Positional : 
-        public Base<Positional<Type>>,
-        public ValueBase<Positional<Type>, Type>
-    {
-        private:
-        using BaseType = Base<Positional<Type>>;
-        Positional(const Positional &) = delete;
-        Positional &operator=(const Positional &) = delete;
-
-        public:
-        Positional(const String &name) : BaseType(name) {}
+    /** Whether a character is whitespace in the classic locale
+     */
+    static bool IsSpace(const Char c) {
+        return c == Char(' ') || (c >= Char('\t') && c <= Char('\r'));
+    }
 
-        Positional(Positional &&other) = default;
-        Positional &operator=(Positional &&) = default;
-        virtual ~Positional() = default;
-    };
+    /** Skip the leading whitespace that stream extraction would skip
+     */
+    static std::size_t SkipSpace(const StringView &value) {
+        std::size_t pos = 0;
+        while (pos < value.size() && IsSpace(value[pos])) {
+            ++pos;
+        }
+        return pos;
+    }
 
-    String _prog;
-    String _description;
-    String _epilog;
-    String _long_prefix;
-    String _short_prefix;
-    String _long_separator;
-    String _option_terminator;
-    String _error;
-    String _long_error;
-    bool _joined_short;
-    bool _joined_long;
-    bool _separate_short;
-    bool _separate_long;
+    static bool IsDigit(const Char c) {
+        return c >= Char('0') && c <= Char('9');
+    }
 
-    // Need pointers for virtual functions
-    List<std::unique_ptr<OptionBase>> _options;
-    List<std::unique_ptr<ValueRoot>> _positionals;
+    template <typename T>
+    static T Negate(const unsigned long long magnitude, std::true_type) {
+        // Written so that the most negative value doesn't overflow
+        return magnitude == 0 ? T(0)
+                              : static_cast<T>(
+                                    -static_cast<T>(magnitude - 1) - T(1));
+    }
 
     template <typename T>
-    OptionBase *MatchOption(const T &flag) {
-        for (const auto &option : _options) {
-            if (option->Match(flag)) {
-                return option.get();
-            }
-        }
-        return nullptr;
+    static T Negate(const unsigned long long magnitude, std::false_type) {
+        // Like num_get, unsigned types accept a sign and wrap around
+        return static_cast<T>(-static_cast<T>(magnitude));
     }
 
-    ValueRoot *GetNextPositional() {
-        for (const auto &positional : _positionals) {
-            auto root = dynamic_cast<Root *>(positional.get());
-            if (!root->Matched()) {
-                return positional.get();
+    /** Extract an integer in base 10, accepting exactly what stream extraction
+     * followed by the full-consumption check accepts, and leaving the same
+     * value behind on failure.
+     */
+    template <typename T>
+    static bool ExtractInteger(const StringView &value, T &out) {
+        using Limits = std::numeric_limits<T>;
+        std::size_t pos = SkipSpace(value);
+        // Like a failed stream sentry, blank input leaves the value alone
+        if (pos == value.size()) {
+            return false;
+        }
+        bool negative = false;
+        if (pos < value.size() &&
+            (value[pos] == Char('+') || value[pos] == Char('-'))) {
+            negative = value[pos] == Char('-');
+            ++pos;
+        }
+        const unsigned long long limit =
+            static_cast<unsigned long long>(Limits::max()) +
+            (negative && Limits::is_signed ? 1 : 0);
+        const std::size_t digits = pos;
+        unsigned long long magnitude = 0;
+        bool overflow = false;
+        for (; pos < value.size() && IsDigit(value[pos]); ++pos) {
+            const unsigned digit =
+                static_cast<unsigned>(value[pos] - Char('0'));
+            if (magnitude > (limit - digit) / 10) {
+                overflow = true;
+            } else {
+                magnitude = magnitude * 10 + digit;
             }
         }
-        return nullptr;
+        if (pos == digits) {
+            out = T(0);
+            return false;
+        }
+        if (overflow) {
+            out = negative && Limits::is_signed ? Limits::min() : Limits::max();
+            return false;
+        }
+        out = negative
+            ? Negate<T>(magnitude, std::integral_constant<bool,
+                                       Limits::is_signed>())
+            : static_cast<T>(magnitude);
+        return pos == value.size();
     }
 
-    public:
-    ArgumentParser(const String &description = String{},
-        const String &epilog = String{}, const String &prog = String{})
-        : _prog(prog),
-          _description(description),
-          _epilog(epilog),
-          _long_prefix("--"),
-          _short_prefix("-"),
-          _long_separator("="),
-          _option_terminator("--"),
-          _joined_short(true),
-          _joined_long(true),
-          _separate_short(true),
-          _separate_long(true) {}
-
-    template <typename Value>
-    Option<Value> &AddOption(const String &name, Matcher matcher) {
-        // Create an option object, add the pointer to a unique pointer
-        // (implying ownership) to the option array, then return a
-        // reference to it.
-        auto opt = new Option<Value>(name, std::move(matcher));
-        _options.emplace_back(opt);
-        return *opt;
+#ifdef ARGSPLUS_HAVE_STRTOD_L
+    static locale_t ClassicLocale() {
+        static const locale_t classic =
+            newlocale(LC_NUMERIC_MASK, "C", locale_t(0));
+        return classic;
     }
 
-    template <typename Value>
-    Positional<Value> &AddPositional(const String &name) {
-        auto pos = new Positional<Value>(name);
-        _positionals.emplace_back(pos);
-        return *pos;
+    /** Whether the conversions below read "." as the decimal point
+     */
+    static bool ClassicNumbers() { return ClassicLocale() != locale_t(0); }
+    static float ToFloat(const char *text, char **end) {
+        return strtof_l(text, end, ClassicLocale());
+    }
+    static double ToDouble(const char *text, char **end) {
+        return strtod_l(text, end, ClassicLocale());
+    }
+    static long double ToLongDouble(const char *text, char **end) {
+        return strtold_l(text, end, ClassicLocale());
+    }
+#else
+    static bool ClassicNumbers() {
+        const char *const point = std::localeconv()->decimal_point;
+        return point[0] == '.' && point[1] == '\0';
     }
+    static float ToFloat(const char *text, char **end) {
+        return std::strtof(text, end);
+    }
+    static double ToDouble(const char *text, char **end) {
+        return std::strtod(text, end);
+    }
+    static long double ToLongDouble(const char *text, char **end) {
+        return std::strtold(text, end);
+    }
+#endif
 
-    /** Parse all arguments.
+    /** Extract a floating point number through the given strtod-like
+     * function.
      *
-     * \param begin an iterator to the beginning of the argument list
-     * \param end an iterator to the past-the-end element of the argument list
-     * \return the iterator after the last parsed value.  Only useful for
-     * kick-out
+     * Only the characters the stream grammar allows are handed to it, so that
+     * strtod extensions like "inf", "nan", and hex floats are still rejected.
+     * The number is read in the classic locale whatever the C and C++ global
+     * locales are, through a stream when the function can't be made to.
      */
-    template <typename It>
-    bool ParseArgs(It begin, It end) {
-        bool terminated = false;
-
-        // Check all arg chunks
-        for (auto it = begin; it != end; ++it) {
-            const auto &chunk = *it;
-
-            if (!terminated && chunk == _option_terminator) {
-                terminated = true;
-                // If a long arg was found
-            } else if (!terminated && chunk.find(_long_prefix) == 0 &&
-                chunk.size() > _long_prefix.size()) {
-                const auto argchunk = chunk.substr(_long_prefix.size());
-                // Try to separate it, in case of a separator:
-                const auto separator = _long_separator.empty()
-                    ? argchunk.npos
-                    : argchunk.find(_long_separator);
-                // If the separator is in the argument, separate it.
-                const auto arg =
-                    (separator != argchunk.npos ? String(argchunk, 0, separator)
-                                                : argchunk);
-
-                if (auto option = MatchOption(arg)) {
-                    auto root = dynamic_cast<Root *>(option);
-                    root->SetMatched(true);
-                    if (auto value_option =
-                            dynamic_cast<ValueRoot *>(option)) {
-                        if (separator != argchunk.npos) {
-                            if (_joined_long) {
-                                if (!value_option->ParseValue(argchunk.substr(
-                                        separator + _long_separator.size()))) {
-                                    _error.assign("Flag '");
-                                    _error.append(arg);
-                                    _error.append(
-                                        "' received an invalid value");
-                                    return false;
-                                }
-                            } else {
-                                _error.assign("Flag '");
-                                _error.append(arg);
-                                _error.append("' was passed a joined argument, "
-                                              "but these are disallowed");
-                                return false;
-                            }
-                        } else {
-                            ++it;
-                            if (it == end) {
-                                _error.assign("Flag '");
-                                _error.append(arg);
-                                _error.append(
-                                    "' requires an argument but received none");
-                                return false;
-                            }
-
-                            if (_separate_long) {
-                                if (!value_option->ParseValue(*it)) {
-                                    _error.assign("Flag '");
-                                    _error.append(arg);
-                                    _error.append(
-                                        "' received an invalid value");
-                                    return false;
-                                }
-                            } else {
-                                _error.assign("Flag '");
-                                _error.append(arg);
-                                _error.append("' was passed a separate "
-                                              "argument, but these are "
-                                              "disallowed");
-                                return false;
-                            }
-                        }
-                    } else if (separator != argchunk.npos) {
-                        _error.assign(
-                            "Passed an argument into a non-argument flag: ");
-                        _error.append(chunk);
-                        return false;
-                    }
-                } else {
-                    _error.assign("Flag could not be matched: ");
-                    _error.append(arg);
-                    return false;
-                }
-                // Check short args
-            } else if (!terminated && chunk.find(_short_prefix) == 0 &&
-                chunk.size() > _short_prefix.size()) {
-                const auto argchunk = chunk.substr(_short_prefix.size());
-                for (auto argit = std::begin(argchunk);
-                     argit != std::end(argchunk); ++argit) {
-                    const auto arg = *argit;
-
-                    if (auto option = MatchOption(arg)) {
-                        auto root = dynamic_cast<Root *>(option);
-                        root->SetMatched(true);
-                        if (auto value_option =
-                                dynamic_cast<ValueRoot *>(option)) {
-                            const String value(++argit, std::end(argchunk));
-                            if (!value.empty()) {
-                                if (_joined_short) {
-                                    if (!value_option->ParseValue(value)) {
-                                        _error.assign("Flag '");
-                                        _error.append(1, arg);
-                                        _error.append(
-                                            "' received an invalid value");
-                                        return false;
-                                    }
-                                } else {
-                                    _error.assign("Flag '");
-                                    _error.append(1, arg);
-                                    _error.append("' was passed a joined "
-                                                  "argument, but these are "
-                                                  "disallowed");
-                                    return false;
-                                }
-                            } else {
-                                ++it;
-                                if (it == end) {
-                                    _error.assign("Flag '");
-                                    _error.append(1, arg);
-                                    _error.append("' requires an argument but "
-                                                  "received none");
-                                    return false;
-                                }
-
-                                if (_separate_short) {
-                                    if (!value_option->ParseValue(*it)) {
-                                        _error.assign("Flag '");
-                                        _error.append(1, arg);
-                                        _error.append(
-                                            "' received an invalid value");
-                                        return false;
-                                    }
-                                } else {
-                                    _error.assign("Flag '");
-                                    _error.append(1, arg);
-                                    _error.append("' was passed a separate "
-                                                  "argument, but these are "
-                                                  "disallowed");
-                                    return false;
-                                }
-                            }
-                            // Because this argchunk is done regardless, because
-                            // a value option flag was just encountered
-                            break;
-                        }
-                    } else {
-                        _error.assign("Flag could not be matched: ");
-                        _error.append(1, arg);
-                        return false;
-                    }
-                }
-            } else {
-                if (auto pos = GetNextPositional()) {
-                    auto root = dynamic_cast<Root *>(pos);
-                    if (!pos->ParseValue(chunk)) {
-                        _error.assign("Positional '");
-                        _error.append(root->Name());
-                        _error.append("' received an invalid value");
-                        return false;
-                    }
-                    root->SetMatched(true);
-                } else {
-                    _error.assign("Passed in argument, but no positional "
-                                  "arguments were ready to receive it: ");
-                    _error.append(chunk);
-                    return false;
-                }
+    template <typename T>
+    static bool ExtractFloat(const StringView &value, T &out,
+        T (*convert)(const char *, char **)) {
+        using Limits = std::numeric_limits<T>;
+        const StringView number = value.substr(SkipSpace(value));
+        char buffer[64];
+        if (number.empty()) {
+            return false;
+        }
+        if (number.size() >= sizeof(buffer) || !ClassicNumbers()) {
+            return ExtractStream(value, out, std::locale::classic());
+        }
+        std::size_t length = 0;
+        for (; length < number.size(); ++length) {
+            const Char c = number[length];
+            if (!(IsDigit(c) || c == Char('.') || c == Char('e') ||
+                    c == Char('E') || c == Char('+') || c == Char('-'))) {
+                break;
             }
+            buffer[length] = static_cast<char>(c);
         }
-        return true;
+        buffer[length] = '\0';
+        char *end;
+        errno = 0;
+        const T result = convert(buffer, &end);
+        // Stream extraction takes an exponent marker into the number even
+        // with no digits after it, as in "2e", and then converts none of it
+        const bool bareExponent = (*end == 'e' || *end == 'E') &&
+            std::find(buffer, end, 'e') == end &&
+            std::find(buffer, end, 'E') == end;
+        if (end == buffer || bareExponent) {
+            out = T(0);
+            return false;
+        }
+        if (errno == ERANGE &&
+            (result == Limits::infinity() || result == -Limits::infinity())) {
+            out = result > 0 ? Limits::max() : Limits::lowest();
+            return false;
+        }
+        out = result;
+        return end == buffer + number.size();
     }
 
-    /** Parse all arguments.
-     *
-     * \param args an iterable of the arguments
-     * \return the iterator after the last parsed value.  Only useful for
-     * kick-out
+    /** Extract a String the way stream extraction does, as a single word
+     * after any leading whitespace, but assigned in place so that a String
+     * that is already big enough doesn't allocate
      */
-    template <typename T>
-    bool ParseArgs(const T &args) {
-        return ParseArgs(std::begin(args), std::end(args));
+    static bool ExtractValue(const StringView &value, String &out) {
+        const std::size_t start = SkipSpace(value);
+        if (start == value.size()) {
+            return false;
+        }
+        std::size_t end = start;
+        while (end < value.size() && !IsSpace(value[end])) {
+            ++end;
+        }
+        out.assign(value.data() + start, end - start);
+        return end == value.size();
     }
 
-    /** Convenience function to parse the CLI from argc and argv
-     *
-     * Just assigns the program name and vectorizes arguments for passing into
-     * ParseArgs()
-     *
-     * \return whether or not all arguments were parsed.  This works for
-     * detecting kick-out, but is generally useless as it can't do anything with
-     * it.
+    template <typename T, typename = void>
+    struct IsExtractable : std::false_type {};
+    template <typename T>
+    struct IsExtractable<T,
+        decltype(void(std::declval<std::basic_istream<Char> &>() >>
+            std::declval<T &>()))> : std::true_type {};
+
+    /** Extract any type that has a stream extraction operator, which must
+     * consume the entire value
+     */
+    template <typename T>
+    static bool ExtractStream(const StringView &value, T &out) {
+        std::basic_istringstream<Char> ss(
+            std::basic_string<Char>(value.data(), value.size()));
+        ss >> out;
+        if (ss.rdbuf()->in_avail() > 0 || ss.fail()) {
+            return false;
+        }
+        return true;
+    }
+
+    /** Extract with a stream imbued with the given locale
+     */
+    template <typename T>
+    static bool ExtractStream(
+        const StringView &value, T &out, const std::locale &locale) {
+        std::basic_istringstream<Char> ss(
+            std::basic_string<Char>(value.data(), value.size()));
+        ss.imbue(locale);
+        ss >> out;
+        if (ss.rdbuf()->in_avail() > 0 || ss.fail()) {
+            return false;
+        }
+        return true;
+    }
+
+    /** Convert a value into the given type.
+     *
+     * Arithmetic types are converted directly from the view, and everything
+     * else falls back to stream extraction.
+     */
+    template <typename T>
+    static bool ExtractValue(const StringView &value, T &out) {
+        return ExtractValue(value, out, IsExtractable<T>());
+    }
+    template <typename T>
+    static bool ExtractValue(
+        const StringView &value, T &out, std::true_type) {
+        return ExtractStream(value, out);
+    }
+    // Anything else needs a Converter
+    template <typename T>
+    static bool ExtractValue(const StringView &, T &, std::false_type) {
+        return false;
+    }
+    static bool ExtractValue(const StringView &value, short &out) {
+        return ExtractInteger(value, out);
+    }
+    static bool ExtractValue(const StringView &value, int &out) {
+        return ExtractInteger(value, out);
+    }
+    static bool ExtractValue(const StringView &value, long &out) {
+        return ExtractInteger(value, out);
+    }
+    static bool ExtractValue(const StringView &value, long long &out) {
+        return ExtractInteger(value, out);
+    }
+    static bool ExtractValue(const StringView &value, unsigned short &out) {
+        return ExtractInteger(value, out);
+    }
+    static bool ExtractValue(const StringView &value, unsigned int &out) {
+        return ExtractInteger(value, out);
+    }
+    static bool ExtractValue(const StringView &value, unsigned long &out) {
+        return ExtractInteger(value, out);
+    }
+    static bool ExtractValue(
+        const StringView &value, unsigned long long &out) {
+        return ExtractInteger(value, out);
+    }
+    static bool ExtractValue(const StringView &value, float &out) {
+        return ExtractFloat(value, out, &ToFloat);
+    }
+    static bool ExtractValue(const StringView &value, double &out) {
+        return ExtractFloat(value, out, &ToDouble);
+    }
+    static bool ExtractValue(const StringView &value, long double &out) {
+        return ExtractFloat(value, out, &ToLongDouble);
+    }
+
+    /** Lists take each value as a new element, so that a list option can be
+     * repeated and a list positional takes every remaining positional chunk
+     */
+    template <typename T, typename... Rest>
+    static bool ExtractValue(const StringView &value, List<T, Rest...> &out) {
+        T element;
+        if (!ExtractValue(value, element)) {
+            return false;
+        }
+        out.push_back(std::move(element));
+        return true;
+    }
+
+    template <typename T>
+    struct IsList : std::false_type {};
+    template <typename T, typename... Rest>
+    struct IsList<List<T, Rest...>> : std::true_type {};
+
+    // Whether values of a type can be converted without a Converter, which
+    // for a list depends on its elements
+    template <typename T>
+    struct IsReadable : IsExtractable<T> {};
+    template <typename T, typename... Rest>
+    struct IsReadable<List<T, Rest...>> : IsReadable<T> {};
+
+    static std::size_t CountChar(
+        const Char *pos, const Char *end, const Char c, std::false_type) {
+        return static_cast<std::size_t>(std::count(pos, end, c));
+    }
+
+    static std::size_t CountChar(
+        const Char *pos, const Char *end, const Char c, std::true_type) {
+        const unsigned char *bytes =
+            reinterpret_cast<const unsigned char *>(pos);
+        const unsigned char *last =
+            reinterpret_cast<const unsigned char *>(end);
+        std::size_t count = 0;
+#if !defined(ARGSPLUS_NO_SIMD) && defined(__AVX2__)
+        const __m256i needle = _mm256_set1_epi8(static_cast<char>(c));
+        for (; last - bytes >= 32; bytes += 32) {
+            const __m256i block =
+                _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bytes));
+            count += __builtin_popcount(static_cast<unsigned>(
+                _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle))));
+        }
+#endif
+#if !defined(ARGSPLUS_NO_SIMD) && defined(__SSE2__)
+        const __m128i needle16 = _mm_set1_epi8(static_cast<char>(c));
+        for (; last - bytes >= 16; bytes += 16) {
+            const __m128i block =
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(bytes));
+            count += __builtin_popcount(static_cast<unsigned>(
+                _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle16))));
+        }
+#elif !defined(ARGSPLUS_NO_SIMD) && defined(__ARM_NEON) && \
+    defined(__aarch64__)
+        const uint8x16_t needle = vdupq_n_u8(static_cast<unsigned char>(c));
+        for (; last - bytes >= 16; bytes += 16) {
+            count += vaddvq_u8(
+                vandq_u8(vceqq_u8(vld1q_u8(bytes), needle), vdupq_n_u8(1)));
+        }
+#endif
+        (void)last;
+        return count +
+            CountChar(reinterpret_cast<const Char *>(bytes), end, c,
+                std::false_type());
+    }
+
+    /** Count a character in a view, a block at a time with SIMD where Char
+     * is a byte
+     */
+    static std::size_t CountChar(const StringView &text, const Char c) {
+        return CountChar(text.begin(), text.end(), c,
+            std::integral_constant<bool, sizeof(Char) == 1>());
+    }
+
+    // Lists like std::deque that can't reserve simply grow as they go
+    template <typename T>
+    static auto Reserve(T &list, const std::size_t size, int)
+        -> decltype(list.reserve(size), void()) {
+        list.reserve(size);
+    }
+    template <typename T>
+    static void Reserve(T &, std::size_t, long) {}
+
+    /** Split a value at a delimiter, and append each piece to a list as if
+     * it were a value of its own.
+     *
+     * The list reserves room for every piece up front.  If any piece is
+     * invalid, the list is left as it was.
+     */
+    template <typename T, typename... Rest>
+    static bool ExtractDelimited(const StringView &value, const Char delimiter,
+        List<T, Rest...> &out) {
+        const std::size_t size = out.size();
+        Reserve(out, size + CountChar(value, delimiter) + 1, 0);
+        const Char *pos = value.begin();
+        const Char *const end = value.end();
+        while (true) {
+            const Char *next =
+                std::char_traits<Char>::find(pos, end - pos, delimiter);
+            if (!next) {
+                next = end;
+            }
+            if (!ExtractValue(StringView(pos, next - pos), out)) {
+                out.erase(out.begin() + size, out.end());
+                return false;
+            }
+            if (next == end) {
+                return true;
+            }
+            pos = next + 1;
+        }
+    }
+
+    // Only lists are ever delimited
+    template <typename T>
+    static bool ExtractDelimited(const StringView &value, Char, T &out) {
+        return ExtractValue(value, out);
+    }
+
+    template <typename T, typename... Rest>
+    static void Append(List<T, Rest...> &out, List<T, Rest...> &in) {
+        out.insert(out.end(), std::make_move_iterator(in.begin()),
+            std::make_move_iterator(in.end()));
+    }
+    // Only lists are ever converted in pieces
+    template <typename T>
+    static void Append(T &, T &) {}
+
+    // Fewer deferred values than this aren't worth another thread
+    static const std::size_t MinPiece = 1024;
+
+    template <typename OptionType, typename ValueType>
+    class ValueBase : public ValueRoot {
+        private:
+        ValueBase(const ValueBase &) = delete;
+        ValueBase &operator=(const ValueBase &) = delete;
+        ValueType _default;
+        // Converted on first access when parsing lazily
+        mutable ValueType _value;
+        mutable List<Span> _deferred;
+        // The pieces that a long list is converted into across threads
+        mutable List<ValueType> _pieces;
+        Converter<ValueType> _converter;
+        Char _delimiter;
+        bool _delimited;
+
+        bool Extract(const StringView &value, ValueType &out) const {
+            if (_converter) {
+                return _converter(value, out);
+            }
+            return _delimited ? ExtractDelimited(value, _delimiter, out)
+                              : ExtractValue(value, out);
+        }
+
+        public:
+        ValueBase()
+            : _default(), _value(), _delimiter(), _delimited(false) {}
+        ValueBase(ValueBase &&other) = default;
+        ValueBase &operator=(ValueBase &&) = default;
+        virtual ~ValueBase() = default;
+
+        virtual bool ParseValue(const StringView &value) {
+            return Extract(value, _value);
+        }
+
+        virtual bool Converts() const { return bool(_converter); }
+
+        /** Restore the default value.  Assigning over the current value lets
+         * it keep any storage it has already allocated.
+         */
+        virtual void Reset() {
+            _value = _default;
+            _deferred.clear();
+        }
+
+        virtual void Defer(const Span &span) {
+            if (!IsList<ValueType>::value) {
+                _deferred.clear();
+            }
+            _deferred.push_back(span);
+        }
+
+        virtual bool Resolve(Span &failed) const {
+            bool valid = true;
+            for (const Span &span : _deferred) {
+                if (!Extract(span.value, _value)) {
+                    failed = span;
+                    valid = false;
+                    break;
+                }
+            }
+            _deferred.clear();
+            return valid;
+        }
+
+        // Lists whose values don't depend on the ones before split evenly;
+        // anything else is a single piece that converts in place
+        virtual std::size_t SplitDeferred(const std::size_t most) const {
+            std::size_t pieces = _deferred.size() / MinPiece;
+            if (!IsList<ValueType>::value || _converter || pieces < 2) {
+                return 1;
+            }
+            pieces = pieces < most ? pieces : most;
+            _pieces.resize(pieces);
+            return pieces;
+        }
+
+        virtual bool ResolvePiece(const std::size_t piece, Span &failed) const {
+            if (_pieces.empty()) {
+                return Resolve(failed);
+            }
+            const std::size_t size = _deferred.size();
+            const std::size_t end = size * (piece + 1) / _pieces.size();
+            for (std::size_t i = size * piece / _pieces.size(); i < end; ++i) {
+                if (!Extract(_deferred[i].value, _pieces[piece])) {
+                    failed = _deferred[i];
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        virtual void JoinPieces(const std::size_t pieces) const {
+            for (std::size_t i = 0; i < pieces && i < _pieces.size(); ++i) {
+                Append(_value, _pieces[i]);
+            }
+            _pieces.clear();
+            _deferred.clear();
+        }
+
+        virtual std::size_t SlotSize() const { return sizeof(ValueType); }
+        virtual std::size_t SlotAlignment() const {
+            return alignof(ValueType);
+        }
+        virtual void ConstructSlot(void *slot) const {
+            new (slot) ValueType(_default);
+        }
+        virtual void ResetSlot(void *slot) const {
+            *static_cast<ValueType *>(slot) = _default;
+        }
+        virtual void DestroySlot(void *slot) const {
+            static_cast<ValueType *>(slot)->~ValueType();
+        }
+        virtual bool ParseSlot(void *slot, const StringView &value) const {
+            return Extract(value, *static_cast<ValueType *>(slot));
+        }
+
+        using Column = List<ValueType>;
+        virtual std::size_t ColumnSize() const { return sizeof(Column); }
+        virtual std::size_t ColumnAlignment() const { return alignof(Column); }
+        virtual void ConstructColumn(void *column) const {
+            new (column) Column();
+        }
+        virtual void DestroyColumn(void *column) const {
+            static_cast<Column *>(column)->~Column();
+        }
+        virtual void ResizeColumn(void *column, std::size_t size) const {
+            Column &values = *static_cast<Column *>(column);
+            values.clear();
+            values.resize(size);
+        }
+        // Moves the value out, which is fine because the slot is reset before
+        // it is parsed into again
+        virtual void StoreColumn(
+            void *column, std::size_t row, void *slot) const {
+            (*static_cast<Column *>(column))[row] =
+                std::move(*static_cast<ValueType *>(slot));
+        }
+
+        const ValueType &Default() const { return _default; }
+
+        OptionType &Default(const ValueType &defaultvalue) {
+            _default = defaultvalue;
+            _value = defaultvalue;
+            _deferred.clear();
+            return *static_cast<OptionType *>(this);
+        }
+
+        /** Take the default by move, which leaves a single copy of it in the
+         * current value
+         */
+        OptionType &Default(ValueType &&defaultvalue) {
+            _value = defaultvalue;
+            _default = std::move(defaultvalue);
+            _deferred.clear();
+            return *static_cast<OptionType *>(this);
+        }
+
+        /** Construct the default from the given arguments, as if by
+         * Default(ValueType(args...))
+         */
+        template <typename... Args>
+        OptionType &EmplaceDefault(Args &&... args) {
+            return Default(ValueType(std::forward<Args>(args)...));
+        }
+
+        /** Convert values with the given Converter rather than ExtractValue,
+         * or with ExtractValue again if it is null.  Types without a stream
+         * extraction operator are given their Converter when they are added
+         * or bound, and every parse fails with a schema error if it is
+         * cleared.
+         */
+        OptionType &Convert(const Converter<ValueType> &converter) {
+            _converter = converter;
+            return *static_cast<OptionType *>(this);
+        }
+
+        /** Split every value of a list at the delimiter, so that with ','
+         * the value "a,b,c" appends three elements, each converted as a
+         * value of its own
+         */
+        OptionType &Delimiter(const Char delimiter) {
+            static_assert(IsList<ValueType>::value,
+                "only list values can be delimited");
+            _delimiter = delimiter;
+            _delimited = true;
+            return *static_cast<OptionType *>(this);
+        }
+
+        /** Get the value, converting it first if it was parsed lazily.
+         *
+         * A lazy value that fails to convert is left as the conversion left
+         * it; use ArgumentParser::Validate() to find such failures.
+         */
+        const ValueType &Value() const {
+            if (!_deferred.empty()) {
+                Span failed;
+                Resolve(failed);
+            }
+            return _value;
+        }
+
+        OptionType &Value(const ValueType &value) {
+            _value = value;
+            _deferred.clear();
+            return *static_cast<OptionType *>(this);
+        }
+
+        OptionType &Value(ValueType &&value) {
+            _value = std::move(value);
+            _deferred.clear();
+            return *static_cast<OptionType *>(this);
+        }
+
+        /** Move the value out, converting it first if it was parsed lazily.
+         *
+         * What is left behind is moved-from until the next parse or Reset()
+         * restores the default.
+         */
+        ValueType TakeValue() {
+            Value();
+            return std::move(_value);
+        }
+    };
+
+    template <typename Type>
+    class Option :
+        public Base<Option<Type>>,
+        public OptionBase,
+        public ValueBase<Option<Type>, Type>
+    {
+        private:
+        using BaseType = Base<Option<Type>>;
+        Option(const Option &) = delete;
+        Option &operator=(const Option &) = delete;
+
+        public:
+        Option(Arena *const *arena, const StringView &name, const Flags &flags)
+            : BaseType(arena, name), OptionBase(flags) {}
+
+        Option(Option &&other) = default;
+        Option &operator=(Option &&) = default;
+        virtual ~Option() = default;
+    };
+
+    template <typename Type>
+    class Positional : 
+        public Base<Positional<Type>>,
+        public ValueBase<Positional<Type>, Type>
+    {
+        private:
+        using BaseType = Base<Positional<Type>>;
+        Positional(const Positional &) = delete;
+        Positional &operator=(const Positional &) = delete;
+
+        public:
+        Positional(Arena *const *arena, const StringView &name)
+            : BaseType(arena, name) {}
+
+        Positional(Positional &&other) = default;
+        Positional &operator=(Positional &&) = default;
+        virtual ~Positional() = default;
+    };
+
+    public:
+    /** A whole file, memory-mapped where possible, and read into a buffer
+     * where it isn't, such as for pipes and empty files
+     */
+    class MappedFile {
+        private:
+        const Char *_data;
+        std::size_t _size;
+        std::size_t _bytes;
+        bool _valid;
+        bool _mapped;
+        String _buffer;
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        bool MapFile(const char *path) {
+#ifdef ARGSPLUS_HAVE_MMAP
+            const int fd = ::open(path, O_RDONLY);
+            if (fd < 0) {
+                return false;
+            }
+            struct stat info;
+            void *data = MAP_FAILED;
+            if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode) &&
+                info.st_size > 0) {
+                data = ::mmap(
+                    nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            }
+            ::close(fd);
+            if (data == MAP_FAILED) {
+                return false;
+            }
+            _data = static_cast<const Char *>(data);
+            _bytes = info.st_size;
+            _size = _bytes / sizeof(Char);
+            _mapped = true;
+            return true;
+#else
+            (void)path;
+            return false;
+#endif
+        }
+
+        public:
+        explicit MappedFile(const char *path)
+            : _data(nullptr),
+              _size(0),
+              _bytes(0),
+              _valid(false),
+              _mapped(false) {
+            if (MapFile(path)) {
+                _valid = true;
+                return;
+            }
+            std::basic_ifstream<Char> file(path, std::ios::binary);
+            if (!file.is_open()) {
+                return;
+            }
+            _buffer.assign(std::istreambuf_iterator<Char>(file),
+                std::istreambuf_iterator<Char>());
+            if (file.bad()) {
+                return;
+            }
+            _data = _buffer.data();
+            _size = _buffer.size();
+            _valid = true;
+        }
+
+        ~MappedFile() {
+#ifdef ARGSPLUS_HAVE_MMAP
+            if (_mapped) {
+                ::munmap(const_cast<Char *>(_data), _bytes);
+            }
+#endif
+        }
+
+        /** Whether the file could be read
+         */
+        bool Valid() const { return _valid; }
+
+        StringView View() const { return StringView(_data, _size); }
+    };
+
+    /** Splits text into words the way that a response file is read.
+     *
+     * Words are separated by whitespace.  A backslash makes the character
+     * after it literal, single quotes make everything up to the next single
+     * quote literal, and double quotes do the same except that backslashes
+     * still escape within them.  A word without any of these is a view of the
+     * text itself; any other is unescaped into a buffer that the Tokenizer
+     * reuses, so that each word is only valid until the next one.
+     *
+     * Where Char is a byte, the text is scanned for the next whitespace,
+     * quote, or backslash 16 or 32 bytes at a time with SIMD.
+     */
+    class Tokenizer {
+        private:
+        StringView _text;
+        std::size_t _pos;
+        String _word;
+        bool _copied;
+        bool _unterminated;
+
+        static bool IsSpecial(const Char c) {
+            return IsSpace(c) || c == Char('\'') || c == Char('"') ||
+                c == Char('\\');
+        }
+
+        static const Char *FindSpecial(
+            const Char *pos, const Char *end, std::false_type) {
+            while (pos != end && !IsSpecial(*pos)) {
+                ++pos;
+            }
+            return pos;
+        }
+
+        // Every helper below marks the bytes that are whitespace in the
+        // classic locale, quotes, or backslashes.  Whitespace other than a
+        // space is the range '\t' to '\r', which is a saturating subtraction.
+#if !defined(ARGSPLUS_NO_SIMD) && defined(__AVX2__)
+        static unsigned SpecialMask(const unsigned char *pos) {
+            const __m256i bytes =
+                _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pos));
+            const __m256i quoted = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' ')),
+                    _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\''))),
+                _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('"')),
+                    _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\\'))));
+            const __m256i control = _mm256_cmpeq_epi8(
+                _mm256_subs_epu8(
+                    _mm256_sub_epi8(bytes, _mm256_set1_epi8('\t')),
+                    _mm256_set1_epi8('\r' - '\t')),
+                _mm256_setzero_si256());
+            return _mm256_movemask_epi8(_mm256_or_si256(quoted, control));
+        }
+#endif
+#if !defined(ARGSPLUS_NO_SIMD) && defined(__SSE2__)
+        static unsigned SpecialMask16(const unsigned char *pos) {
+            const __m128i bytes =
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(pos));
+            const __m128i quoted = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')),
+                    _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\''))),
+                _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('"')),
+                    _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\\'))));
+            const __m128i control = _mm_cmpeq_epi8(
+                _mm_subs_epu8(_mm_sub_epi8(bytes, _mm_set1_epi8('\t')),
+                    _mm_set1_epi8('\r' - '\t')),
+                _mm_setzero_si128());
+            return _mm_movemask_epi8(_mm_or_si128(quoted, control));
+        }
+#elif !defined(ARGSPLUS_NO_SIMD) && defined(__ARM_NEON) && \
+    defined(__aarch64__)
+        static bool AnySpecial16(const unsigned char *pos) {
+            const uint8x16_t bytes = vld1q_u8(pos);
+            const uint8x16_t quoted =
+                vorrq_u8(vorrq_u8(vceqq_u8(bytes, vdupq_n_u8(' ')),
+                             vceqq_u8(bytes, vdupq_n_u8('\''))),
+                    vorrq_u8(vceqq_u8(bytes, vdupq_n_u8('"')),
+                        vceqq_u8(bytes, vdupq_n_u8('\\'))));
+            const uint8x16_t control = vcleq_u8(
+                vsubq_u8(bytes, vdupq_n_u8('\t')), vdupq_n_u8('\r' - '\t'));
+            return vmaxvq_u8(vorrq_u8(quoted, control)) != 0;
+        }
+#endif
+
+        static const Char *FindSpecial(
+            const Char *pos, const Char *end, std::true_type) {
+            const unsigned char *bytes =
+                reinterpret_cast<const unsigned char *>(pos);
+            const unsigned char *last =
+                reinterpret_cast<const unsigned char *>(end);
+#if !defined(ARGSPLUS_NO_SIMD) && defined(__AVX2__)
+            for (; last - bytes >= 32; bytes += 32) {
+                if (const unsigned mask = SpecialMask(bytes)) {
+                    return reinterpret_cast<const Char *>(bytes) +
+                        __builtin_ctz(mask);
+                }
+            }
+#endif
+#if !defined(ARGSPLUS_NO_SIMD) && defined(__SSE2__)
+            for (; last - bytes >= 16; bytes += 16) {
+                if (const unsigned mask = SpecialMask16(bytes)) {
+                    return reinterpret_cast<const Char *>(bytes) +
+                        __builtin_ctz(mask);
+                }
+            }
+#elif !defined(ARGSPLUS_NO_SIMD) && defined(__ARM_NEON) && \
+    defined(__aarch64__)
+            // NEON has no movemask, so the block that hits is finished below
+            for (; last - bytes >= 16 && !AnySpecial16(bytes); bytes += 16) {
+            }
+#endif
+            (void)last;
+            return FindSpecial(reinterpret_cast<const Char *>(bytes), end,
+                std::false_type());
+        }
+
+        // The first special character at or after pos
+        std::size_t FindSpecial(const std::size_t pos) const {
+            return FindSpecial(_text.begin() + pos, _text.end(),
+                       std::integral_constant<bool, sizeof(Char) == 1>()) -
+                _text.begin();
+        }
+
+        public:
+        explicit Tokenizer(const StringView &text)
+            : _text(text), _pos(0), _copied(false), _unterminated(false) {}
+
+        /** Get the next word
+         *
+         * \return false at the end of the text, or at a quote that is never
+         * closed, which Unterminated() tells apart
+         */
+        bool Next(StringView &word) {
+            while (_pos < _text.size() && IsSpace(_text[_pos])) {
+                ++_pos;
+            }
+            if (_pos == _text.size()) {
+                return false;
+            }
+            const std::size_t start = _pos;
+            _pos = FindSpecial(_pos);
+            if (_pos == _text.size() || IsSpace(_text[_pos])) {
+                word = _text.substr(start, _pos - start);
+                _copied = false;
+                return true;
+            }
+
+            _word.assign(_text.data() + start, _pos - start);
+            Char quote = Char();
+            while (_pos < _text.size()) {
+                const Char c = _text[_pos];
+                if (c == Char('\\') && quote != Char('\'') &&
+                    _pos + 1 < _text.size()) {
+                    _word.push_back(_text[_pos + 1]);
+                    _pos += 2;
+                } else if (quote != Char() && c == quote) {
+                    quote = Char();
+                    ++_pos;
+                } else if (quote == Char() &&
+                    (c == Char('\'') || c == Char('"'))) {
+                    quote = c;
+                    ++_pos;
+                } else if (quote == Char() && IsSpace(c)) {
+                    break;
+                } else {
+                    // A plain run, which may begin with a character that is
+                    // only special outside of the current quotes, or with a
+                    // backslash that ends the text
+                    const std::size_t run = FindSpecial(_pos + 1);
+                    _word.append(_text.data() + _pos, run - _pos);
+                    _pos = run;
+                }
+            }
+            if (quote != Char()) {
+                _unterminated = true;
+                return false;
+            }
+            word = StringView(_word);
+            _copied = true;
+            return true;
+        }
+
+        /** Whether the last word was unescaped into the Tokenizer's buffer,
+         * rather than viewing the text
+         */
+        bool Copied() const { return _copied; }
+
+        bool Unterminated() const { return _unterminated; }
+    };
+
+    private:
+    /** A monotonic arena that the nodes are constructed in, with their
+     * names, help, and flags.
+     *
+     * Nodes are never freed one at a time, so they are simply bumped into
+     * blocks from the Allocator, which sit next to each other and are all
+     * released at once when the parser goes away.  Each block is twice the
+     * size of the one before it, so that a parser takes a few blocks however
+     * many nodes it has.  Only the values of the nodes allocate for
+     * themselves.
+     */
+    class Arena {
+        private:
+        struct Block {
+            Block *next;
+            std::size_t size;
+        };
+
+        Block *_blocks;
+        unsigned char *_cursor;
+        std::size_t _remaining;
+        std::size_t _next_size;
+        // A pointer to the arena, kept in the arena so that nodes can find it
+        // through the parser moving
+        Arena **_self;
+
+        Arena(const Arena &) = delete;
+        Arena &operator=(const Arena &) = delete;
+
+        public:
+        static const std::size_t BlockSize = 4096;
+
+        Arena()
+            : _blocks(nullptr),
+              _cursor(nullptr),
+              _remaining(0),
+              _next_size(BlockSize),
+              _self(nullptr) {}
+        Arena(Arena &&other)
+            : _blocks(other._blocks),
+              _cursor(other._cursor),
+              _remaining(other._remaining),
+              _next_size(other._next_size),
+              _self(other._self) {
+            if (_self) {
+                *_self = this;
+            }
+            other._blocks = nullptr;
+            other._cursor = nullptr;
+            other._remaining = 0;
+            other._next_size = BlockSize;
+            other._self = nullptr;
+        }
+        Arena &operator=(Arena &&) = delete;
+
+        ~Arena() {
+            Allocator<unsigned char> allocator;
+            while (_blocks) {
+                Block *next = _blocks->next;
+                allocator.deallocate(
+                    reinterpret_cast<unsigned char *>(_blocks), _blocks->size);
+                _blocks = next;
+            }
+        }
+
+        static std::size_t Padding(
+            const unsigned char *cursor, const std::size_t alignment) {
+            const std::size_t offset =
+                reinterpret_cast<std::uintptr_t>(cursor) % alignment;
+            return offset ? alignment - offset : 0;
+        }
+
+        void *Allocate(const std::size_t size, const std::size_t alignment) {
+            std::size_t padding = Padding(_cursor, alignment);
+            if (padding + size > _remaining) {
+                // Oversized nodes get a block of their own
+                const std::size_t needed = sizeof(Block) + alignment + size;
+                const std::size_t blockSize =
+                    needed > _next_size ? needed : _next_size;
+                _next_size *= 2;
+                Allocator<unsigned char> allocator;
+                Block *block =
+                    reinterpret_cast<Block *>(allocator.allocate(blockSize));
+                block->next = _blocks;
+                block->size = blockSize;
+                _blocks = block;
+                _cursor = reinterpret_cast<unsigned char *>(block + 1);
+                _remaining = blockSize - sizeof(Block);
+                padding = Padding(_cursor, alignment);
+            }
+            void *memory = _cursor + padding;
+            _cursor += padding + size;
+            _remaining -= padding + size;
+            return memory;
+        }
+
+        /** Copy the characters into the arena
+         *
+         * \return a view of the copy, which lasts as long as the arena
+         */
+        StringView Copy(const StringView &text) {
+            if (text.empty()) {
+                return StringView();
+            }
+            Char *const copy = static_cast<Char *>(
+                Allocate(text.size() * sizeof(Char), alignof(Char)));
+            std::copy(text.begin(), text.end(), copy);
+            return StringView(copy, text.size());
+        }
+
+        /** Where the arena is, wherever it is moved to
+         */
+        Arena *const *Self() {
+            if (!_self) {
+                _self = new (Allocate(sizeof(Arena *), alignof(Arena *)))
+                    Arena *(this);
+            }
+            return _self;
+        }
+    };
+
+    String _prog;
+    String _description;
+    String _epilog;
+    String _long_prefix;
+    String _short_prefix;
+    String _long_separator;
+    String _option_terminator;
+    // Whether the syntax is the usual "--", "-", and "--", which chunks are
+    // classified by with the fast path of Classify()
+    bool _dash_syntax;
+    String _long_error;
+    String _schema_error;
+    bool _joined_short;
+    bool _joined_long;
+    bool _separate_short;
+    bool _separate_long;
+    bool _frozen;
+    bool _lazy;
+    bool _response_files;
+
+    /** A registered option or positional.
+     *
+     * The pointers to each of its interfaces are taken from its static type
+     * when it is added, so that the parse loop never needs to cross-cast
+     * through the class lattice, and the library works without RTTI.
+     */
+    struct Node {
+        Root *root;
+        ValueRoot *value;
+        // Whether it takes any number of values
+        bool list;
+        // Its position in _storage, and so in a Result
+        std::size_t slot;
+    };
+
+    // Need pointers for virtual functions.  Every node lives in the arena and
+    // is destroyed through its common Root, in reverse order of creation.
+    Arena _arena;
+    List<Root *> _storage;
+    List<Node> _options;
+    List<Node> _positionals;
+    // The flags of each option, for rendering help
+    List<const Flags *> _option_flags;
+    // The nodes whose values can't be read from a stream, so that they need
+    // a Converter before they are parsed
+    List<Node> _unreadable;
+    // Whether each node is matched, by slot, once the parser is frozen.  It
+    // is written by the same parses that write the nodes' values.
+    mutable List<std::uint64_t> _matched_bits;
+
+    /** Writes the schema blob of SaveSchema(): integers in the byte order
+     * of the host, and text aligned for Char, so that a loaded parser can
+     * view the text in place
+     */
+    class SchemaWriter {
+        private:
+        List<unsigned char> &_blob;
+
+        public:
+        explicit SchemaWriter(List<unsigned char> &blob) : _blob(blob) {}
+
+        void Integer(const std::uint64_t value) {
+            const unsigned char *bytes =
+                reinterpret_cast<const unsigned char *>(&value);
+            _blob.insert(_blob.end(), bytes, bytes + sizeof(value));
+        }
+
+        void Text(const StringView &text) {
+            Integer(text.size());
+            const std::size_t align = sizeof(Char);
+            _blob.resize((_blob.size() + align - 1) / align * align);
+            const unsigned char *bytes =
+                reinterpret_cast<const unsigned char *>(text.data());
+            _blob.insert(_blob.end(), bytes, bytes + text.size() * align);
+        }
+    };
+
+    /** Reads a schema blob, checking every read against its end, so that a
+     * truncated blob is only ever invalid
+     */
+    class SchemaReader {
+        private:
+        const unsigned char *_begin;
+        const unsigned char *_pos;
+        const unsigned char *_end;
+        bool _valid;
+
+        public:
+        SchemaReader(const unsigned char *begin, const unsigned char *end)
+            : _begin(begin),
+              _pos(begin),
+              _end(end),
+              _valid(true) {}
+
+        bool Valid() const { return _valid; }
+        void Invalidate() { _valid = false; }
+
+        std::uint64_t Integer() {
+            std::uint64_t value = 0;
+            if (static_cast<std::size_t>(_end - _pos) < sizeof(value)) {
+                _valid = false;
+                return 0;
+            }
+            std::memcpy(&value, _pos, sizeof(value));
+            _pos += sizeof(value);
+            return value;
+        }
+
+        /** Read an index, which is valid if it is below the limit or is one
+         * of the given markers
+         */
+        std::size_t Index(const std::size_t limit,
+            const std::size_t marker = static_cast<std::size_t>(-1),
+            const std::size_t other = static_cast<std::size_t>(-1)) {
+            const std::uint64_t value = Integer();
+            const std::size_t index = static_cast<std::size_t>(value);
+            if (index != value ||
+                (index >= limit && index != marker && index != other)) {
+                _valid = false;
+            }
+            return index;
+        }
+
+        StringView Text() {
+            const std::uint64_t size = Integer();
+            const std::size_t offset = static_cast<std::size_t>(_pos - _begin);
+            const std::size_t padding =
+                (sizeof(Char) - offset % sizeof(Char)) % sizeof(Char);
+            if (!_valid ||
+                static_cast<std::size_t>(_end - _pos) < padding ||
+                (static_cast<std::size_t>(_end - _pos) - padding) /
+                        sizeof(Char) < size) {
+                _valid = false;
+                return StringView();
+            }
+            _pos += padding;
+            const StringView text(reinterpret_cast<const Char *>(_pos),
+                static_cast<std::size_t>(size));
+            _pos += text.size() * sizeof(Char);
+            return text;
+        }
+
+        bool AtEnd() const { return _pos == _end; }
+    };
+
+    /** A radix tree of every long flag of the parser.
+     *
+     * Each edge is labelled by a range of one buffer holding a copy of
+     * every flag's characters.  A flag is found with one walk over its
+     * characters, straight out of the chunk, stopping at the long
+     * separator.  Every node also knows whether the flags below it all belong
+     * to a single option, which makes unique-prefix abbreviations free.
+     */
+    class LongTrie {
+        public:
+        static const std::size_t None = static_cast<std::size_t>(-1);
+        static const std::size_t Ambiguous = None - 1;
+
+        struct Found {
+            // An index into _options, or None, or Ambiguous
+            std::size_t option;
+            // The whole flag that was matched, viewing the option's copy
+            StringView flag;
+            // How much of the text is the flag, up to the separator
+            std::size_t length;
+        };
+
+        private:
+        struct TrieNode {
+            // The first character of the label, kept here so that looking for
+            // a child only touches the nodes
+            Char first;
+            // The label, as a range of _labels
+            std::size_t offset;
+            std::size_t length;
+            std::size_t child;
+            std::size_t sibling;
+            // The option whose flag ends here, and that flag
+            std::size_t option;
+            StringView flag;
+            // The option of every flag at or below here, or Ambiguous, and
+            // one of those flags
+            std::size_t below;
+            StringView belowFlag;
+        };
+
+        // The root is the empty flag.  The labels of all nodes are copied
+        // next to each other, so that a walk stays in a few cache lines
+        // rather than visiting each option's flags.
+        List<TrieNode> _nodes;
+        String _labels;
+
+        std::size_t FindChild(const std::size_t node, const Char c) const {
+            std::size_t child = _nodes[node].child;
+            while (child != None && _nodes[child].first != c) {
+                child = _nodes[child].sibling;
+            }
+            return child;
+        }
+
+        StringView Label(const TrieNode &node) const {
+            return StringView(_labels.data() + node.offset, node.length);
+        }
+
+        void Mark(const std::size_t node, const std::size_t option,
+            const StringView &flag) {
+            TrieNode &entry = _nodes[node];
+            if (entry.below == None) {
+                entry.below = option;
+                entry.belowFlag = flag;
+            } else if (entry.below != option) {
+                entry.below = Ambiguous;
+            }
+        }
+
+        static bool AtEnd(const StringView &text, const std::size_t pos,
+            const StringView &separator) {
+            // The first character is checked on its own, so that most
+            // characters are passed over without a call to compare()
+            return pos == text.size() ||
+                (!separator.empty() && text[pos] == separator[0] &&
+                    text.substr(pos).StartsWith(separator));
+        }
+
+        // Nothing matched, so the flag runs up to the separator
+        static Found Unmatched(
+            const StringView &text, const StringView &separator) {
+            const std::size_t length = separator.empty()
+                ? text.size()
+                : std::min(text.find(separator), text.size());
+            return Found{None, StringView(), length};
+        }
+
+        public:
+        LongTrie()
+            : _nodes(1, TrieNode{Char(), 0, 0, None, None, None, StringView(),
+                            None, StringView()}) {}
+
+        /** Add a flag of an option
+         *
+         * \return false if the flag already belongs to an option, which it
+         * keeps
+         */
+        bool Insert(const StringView &flag, const std::size_t option) {
+            // Checked with a walk of its own before any node is marked, so
+            // that a rejected flag leaves abbreviations as they were
+            if (Find(flag, StringView(), false).option != None) {
+                return false;
+            }
+            std::size_t node = 0;
+            std::size_t pos = 0;
+            Mark(node, option, flag);
+            while (pos < flag.size()) {
+                const std::size_t child = FindChild(node, flag[pos]);
+                if (child == None) {
+                    _nodes.push_back(TrieNode{flag[pos], _labels.size(),
+                        flag.size() - pos, None, _nodes[node].child, option,
+                        flag, option, flag});
+                    _labels.append(flag.data() + pos, flag.size() - pos);
+                    _nodes[node].child = _nodes.size() - 1;
+                    return true;
+                }
+                const StringView label = Label(_nodes[child]);
+                std::size_t common = 1;
+                while (common < label.size() && pos + common < flag.size() &&
+                    label[common] == flag[pos + common]) {
+                    ++common;
+                }
+                if (common < label.size()) {
+                    // Split the edge, moving the rest of it to a new child
+                    TrieNode rest = _nodes[child];
+                    rest.first = label[common];
+                    rest.offset += common;
+                    rest.length -= common;
+                    rest.sibling = None;
+                    _nodes.push_back(rest);
+                    TrieNode &split = _nodes[child];
+                    split.length = common;
+                    split.child = _nodes.size() - 1;
+                    split.option = None;
+                    split.flag = StringView();
+                }
+                pos += common;
+                node = child;
+                Mark(node, option, flag);
+            }
+            _nodes[node].option = option;
+            _nodes[node].flag = flag;
+            return true;
+        }
+
+        /** Find the flag that text begins with, up to the separator or the
+         * end of the text.
+         *
+         * \param abbreviate whether a flag may be given as any prefix of it
+         * that is shared by no other option's flags.  A whole flag always
+         * wins over an abbreviation.
+         */
+        Found Find(const StringView &text, const StringView &separator,
+            const bool abbreviate) const {
+            std::size_t node = 0;
+            std::size_t pos = 0;
+            while (!AtEnd(text, pos, separator)) {
+                const std::size_t child = FindChild(node, text[pos]);
+                if (child == None) {
+                    return Unmatched(text, separator);
+                }
+                const StringView label = Label(_nodes[child]);
+                std::size_t matched = 1;
+                ++pos;
+                while (matched < label.size() && !AtEnd(text, pos, separator) &&
+                    text[pos] == label[matched]) {
+                    ++matched;
+                    ++pos;
+                }
+                if (matched < label.size()) {
+                    if (abbreviate && AtEnd(text, pos, separator)) {
+                        return Found{_nodes[child].below,
+                            _nodes[child].belowFlag, pos};
+                    }
+                    return Unmatched(text, separator);
+                }
+                node = child;
+            }
+            const TrieNode &entry = _nodes[node];
+            if (entry.option != None) {
+                return Found{entry.option, entry.flag, pos};
+            }
+            if (abbreviate && pos > 0) {
+                return Found{entry.below, entry.belowFlag, pos};
+            }
+            return Found{None, StringView(), pos};
+        }
+
+        /** Write every node of the tree to a schema blob
+         */
+        void Save(SchemaWriter &writer) const {
+            writer.Integer(_nodes.size());
+            writer.Text(_labels);
+            for (const TrieNode &node : _nodes) {
+                writer.Integer(static_cast<std::uint64_t>(node.first));
+                writer.Integer(node.offset);
+                writer.Integer(node.length);
+                writer.Integer(node.child);
+                writer.Integer(node.sibling);
+                writer.Integer(node.option);
+                writer.Text(node.flag);
+                writer.Integer(node.below);
+                writer.Text(node.belowFlag);
+            }
+        }
+
+        /** Replace the tree with the one in a schema blob, whose flags stay
+         * in the blob
+         *
+         * \param options the number of options that the flags may belong to
+         */
+        void Load(SchemaReader &reader, const std::size_t options) {
+            const std::size_t count = reader.Index(
+                std::numeric_limits<std::size_t>::max() / sizeof(TrieNode));
+            const StringView labels = reader.Text();
+            if (!reader.Valid() || count == 0) {
+                reader.Invalidate();
+                return;
+            }
+            _labels.assign(labels.data(), labels.size());
+            _nodes.resize(count);
+            for (TrieNode &node : _nodes) {
+                node.first = static_cast<Char>(reader.Integer());
+                node.offset = reader.Index(_labels.size() + 1);
+                node.length = reader.Index(_labels.size() - node.offset + 1);
+                node.child = reader.Index(count, None);
+                node.sibling = reader.Index(count, None);
+                node.option = reader.Index(options, None);
+                node.flag = reader.Text();
+                node.below = reader.Index(options, None, Ambiguous);
+                node.belowFlag = reader.Text();
+                if (!reader.Valid()) {
+                    return;
+                }
+            }
+        }
+
+        /** Call visit with every flag that begins with the prefix, and the
+         * option that owns it
+         */
+        template <typename Visit>
+        void Complete(const StringView &prefix, const Visit &visit) const {
+            std::size_t node = 0;
+            std::size_t pos = 0;
+            while (pos < prefix.size()) {
+                const std::size_t child = FindChild(node, prefix[pos]);
+                if (child == None) {
+                    return;
+                }
+                const StringView label = Label(_nodes[child]);
+                std::size_t matched = 1;
+                ++pos;
+                for (; matched < label.size() && pos < prefix.size();
+                     ++matched, ++pos) {
+                    if (prefix[pos] != label[matched]) {
+                        return;
+                    }
+                }
+                node = child;
+            }
+            VisitBelow(node, visit);
+        }
+
+        template <typename Visit>
+        void VisitBelow(const std::size_t node, const Visit &visit) const {
+            const TrieNode &entry = _nodes[node];
+            if (entry.option != None) {
+                visit(entry.flag, entry.option);
+            }
+            for (std::size_t child = entry.child; child != None;
+                 child = _nodes[child].sibling) {
+                VisitBelow(child, visit);
+            }
+        }
+    };
+
+    /** A short flag and the index in _options of the option that owns it
+     */
+    struct ShortEntry {
+        Char flag;
+        std::size_t option;
+    };
+
+    /** The short flags of the parser, in a Map for wide Chars
+     */
+    template <bool Dense, typename = void>
+    class ShortTable {
+        private:
+        Map<Char, ShortEntry> _entries;
+
+        public:
+        bool Insert(const Char flag, const std::size_t option) {
+            return _entries.emplace(flag, ShortEntry{flag, option}).second;
+        }
+
+        const ShortEntry *Find(const Char flag) const {
+            const auto found = _entries.find(flag);
+            return found == std::end(_entries) ? nullptr : &found->second;
+        }
+
+        /** A view of the entry's flag, which moving the Map keeps in place
+         */
+        static StringView View(const ShortEntry &entry) {
+            return StringView(&entry.flag, 1);
+        }
+
+        template <typename Visit>
+        void ForEach(const Visit &visit) const {
+            for (const auto &entry : _entries) {
+                visit(entry.second);
+            }
+        }
+    };
+
+    /** The short flags of the parser, in a table with an entry for every
+     * possible byte, so that a flag is found with a single load
+     */
+    template <typename Unused>
+    class ShortTable<true, Unused> {
+        private:
+        static const std::size_t None = static_cast<std::size_t>(-1);
+        std::array<ShortEntry, 256> _entries;
+
+        static std::size_t Slot(const Char flag) {
+            return static_cast<unsigned char>(flag);
+        }
+
+        // Every byte, in order, for flags to view instead of the entries,
+        // which are copied when the parser is moved
+        static const Char *Bytes() {
+            static const std::array<Char, 256> bytes = [] {
+                std::array<Char, 256> bytes;
+                for (std::size_t i = 0; i < bytes.size(); ++i) {
+                    bytes[i] = static_cast<Char>(i);
+                }
+                return bytes;
+            }();
+            return bytes.data();
+        }
+
+        public:
+        ShortTable() {
+            for (std::size_t i = 0; i < _entries.size(); ++i) {
+                _entries[i] = ShortEntry{static_cast<Char>(i), None};
+            }
+        }
+
+        bool Insert(const Char flag, const std::size_t option) {
+            ShortEntry &entry = _entries[Slot(flag)];
+            if (entry.option != None) {
+                return false;
+            }
+            entry.option = option;
+            return true;
+        }
+
+        const ShortEntry *Find(const Char flag) const {
+            const ShortEntry &entry = _entries[Slot(flag)];
+            return entry.option == None ? nullptr : &entry;
+        }
+
+        /** A view of the entry's flag that outlives the table
+         */
+        static StringView View(const ShortEntry &entry) {
+            return StringView(Bytes() + Slot(entry.flag), 1);
+        }
+
+        template <typename Visit>
+        void ForEach(const Visit &visit) const {
+            for (const ShortEntry &entry : _entries) {
+                if (entry.option != None) {
+                    visit(entry);
+                }
+            }
+        }
+    };
+
+    // Parser-wide flag indices, filled in as options are added, so that a
+    // flag lookup doesn't depend on the number of options
+    ShortTable<sizeof(Char) == 1> _short_table;
+    LongTrie _long_trie;
+    bool _abbreviate;
+
+    public:
+    class Result;
+
+    /** What went wrong in a parse
+     */
+    enum class ErrorCode {
+        None,
+        // The schema is broken; the message says how
+        Schema,
+        // Set through Error(const String &)
+        Custom,
+        UnmatchedFlag,
+        AmbiguousFlag,
+        JoinedArgument,
+        SeparateArgument,
+        NonArgumentFlag,
+        MissingArgument,
+        InvalidValue,
+        UnexpectedPositional,
+        ResponseFileDepth,
+        UnreadableResponseFile,
+        UnterminatedResponseFile,
+        UnterminatedCommand,
+        ResultMismatch
+    };
+
+    /** A parse error, kept in pieces and only rendered to a message when it
+     * is asked for.
+     *
+     * Setting an error just records its code, the index of the argument that
+     * caused it, the option or positional it is about, and a copy of the
+     * offending span of the argument, into storage that is reused from one
+     * error to the next.  This makes rejecting arguments about as cheap as
+     * accepting them.
+     */
+    class ParseError {
+        private:
+        friend class ArgumentParser;
+
+        ErrorCode _code;
+        std::size_t _index;
+        const Root *_target;
+        String _span;
+        mutable String _message;
+        mutable bool _rendered;
+
+        void Assign(const ErrorCode code, const std::size_t index,
+            const Root *target, const StringView &span) {
+            _code = code;
+            _index = index;
+            _target = target;
+            _span.assign(span.data(), span.size());
+            _rendered = false;
+        }
+
+        void Assign(const ErrorCode code, const String &message) {
+            _code = code;
+            _index = 0;
+            _target = nullptr;
+            _span.clear();
+            _message = message;
+            _rendered = true;
+        }
+
+        void Render() const {
+            _message.clear();
+            switch (_code) {
+                case ErrorCode::UnmatchedFlag:
+                    _message.append("Flag could not be matched: ");
+                    _message.append(_span);
+                    break;
+                case ErrorCode::AmbiguousFlag:
+                    _message.append("Flag is ambiguous: ");
+                    _message.append(_span);
+                    break;
+                case ErrorCode::JoinedArgument:
+                    RenderFlag("' was passed a joined argument, but these are "
+                               "disallowed");
+                    break;
+                case ErrorCode::SeparateArgument:
+                    RenderFlag("' was passed a separate argument, but these "
+                               "are disallowed");
+                    break;
+                case ErrorCode::NonArgumentFlag:
+                    _message.append(
+                        "Passed an argument into a non-argument flag: ");
+                    _message.append(_span);
+                    break;
+                case ErrorCode::MissingArgument:
+                    RenderFlag("' requires an argument but received none");
+                    break;
+                case ErrorCode::InvalidValue:
+                    if (_span.empty()) {
+                        _message.append("Positional '");
+                        const StringView name = _target->Name();
+                        _message.append(name.data(), name.size());
+                        _message.append("' received an invalid value");
+                    } else {
+                        RenderFlag("' received an invalid value");
+                    }
+                    break;
+                case ErrorCode::UnexpectedPositional:
+                    _message.append("Passed in argument, but no positional "
+                                    "arguments were ready to receive it: ");
+                    _message.append(_span);
+                    break;
+                case ErrorCode::ResponseFileDepth:
+                    _message.append("Response files are nested too deeply: ");
+                    _message.append(_span);
+                    break;
+                case ErrorCode::UnreadableResponseFile:
+                    _message.append("Could not read response file: ");
+                    _message.append(_span);
+                    break;
+                case ErrorCode::UnterminatedResponseFile:
+                    _message.append(
+                        "Response file has an unterminated quote: ");
+                    _message.append(_span);
+                    break;
+                case ErrorCode::UnterminatedCommand:
+                    _message.append("Command has an unterminated quote");
+                    break;
+                case ErrorCode::ResultMismatch:
+                    _message.append(
+                        "Result does not match the options of this parser");
+                    break;
+                default: break;
+            }
+            _rendered = true;
+        }
+
+        void RenderFlag(const char *message) const {
+            _message.append("Flag '");
+            _message.append(_span);
+            _message.append(message);
+        }
+
+        public:
+        ParseError()
+            : _code(ErrorCode::None),
+              _index(0),
+              _target(nullptr),
+              _rendered(true) {}
+
+        ErrorCode Code() const { return _code; }
+
+        /** The index of the argument that caused the error, counting each
+         * word of a command string or response file as one
+         */
+        std::size_t Index() const { return _index; }
+
+        /** The option or positional that the error is about, if any
+         */
+        const Root *Target() const { return _target; }
+
+        /** The offending part of the argument, such as an unmatched flag, or
+         * the flag that a bad value was passed through
+         */
+        StringView Span() const { return StringView(_span); }
+
+        /** The error as text, which is empty when there is no error
+         */
+        const String &Message() const {
+            if (!_rendered) {
+                Render();
+            }
+            return _message;
+        }
+
+        void Clear() {
+            _code = ErrorCode::None;
+            _target = nullptr;
+            _span.clear();
+            _message.clear();
+            _rendered = true;
+        }
+    };
+
+    private:
+    ParseError _error;
+
+    public:
+    /** Counters of what parses do, for exporting to a metrics pipeline.
+     *
+     * Attach one to a parser or a Result with Instrument(), and every parse
+     * through it adds to the counters, until they are cleared.  Nothing is
+     * counted, and no clock is read, unless ARGSPLUS_INSTRUMENT is defined.
+     * A Stats is not synchronized, so give every thread its own.
+     */
+    struct Stats {
+        enum Phase {
+            // Working out whether chunks are flags or positionals
+            Classify,
+            // Looking up flags in the long and short flag indices
+            Lookup,
+            // Converting values with their ParseValue
+            Convert,
+            // Finding the positional that takes a chunk
+            Positional,
+            // Recording errors
+            Error,
+            Phases
+        };
+
+        std::uint64_t chunks;
+        std::uint64_t lookups;
+        std::uint64_t conversions;
+        std::uint64_t positionals;
+        std::uint64_t errors;
+        // Bytes of nodes that the parser allocated in its arena
+        std::uint64_t bytes;
+        // Time stamp counter cycles on x86, and steady clock nanoseconds
+        // elsewhere.  Phases don't nest, except that a failed conversion
+        // counts its error as part of Convert.
+        std::uint64_t cycles[Phases];
+
+        Stats() { Clear(); }
+
+        void Clear() {
+            chunks = 0;
+            lookups = 0;
+            conversions = 0;
+            positionals = 0;
+            errors = 0;
+            bytes = 0;
+            std::fill(std::begin(cycles), std::end(cycles), 0);
+        }
+    };
+
+    private:
+    static const bool Instrumented = ARGSPLUS_INSTRUMENTED;
+
+    static std::uint64_t Cycles() {
+#ifdef ARGSPLUS_HAVE_RDTSC
+        return __rdtsc();
+#else
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch())
+                .count());
+#endif
+    }
+
+    /** Add one to a counter of the Stats, if there are any
+     */
+    static void Count(Stats *stats, std::uint64_t Stats::*counter) {
+        if (Instrumented && stats) {
+            ++(stats->*counter);
+        }
+    }
+
+    /** Adds the time from its construction to its destruction to a phase of
+     * the Stats, if there are any
+     */
+    class PhaseTimer {
+        private:
+        Stats *_stats;
+        typename Stats::Phase _phase;
+        std::uint64_t _start;
+
+        PhaseTimer(const PhaseTimer &) = delete;
+        PhaseTimer &operator=(const PhaseTimer &) = delete;
+
+        public:
+        PhaseTimer(Stats *stats, const typename Stats::Phase phase)
+            : _stats(Instrumented ? stats : nullptr),
+              _phase(phase),
+              _start(_stats ? Cycles() : 0) {}
+
+        ~PhaseTimer() {
+            if (_stats) {
+                _stats->cycles[_phase] += Cycles() - _start;
+            }
+        }
+    };
+
+    Stats *_stats;
+
+    /** A subcommand, whose parser is only built, by its factory, once the
+     * subcommand is first selected
+     */
+    struct CommandNode {
+        String name;
+        String help;
+        std::function<void(ArgumentParser &)> factory;
+        std::unique_ptr<ArgumentParser> parser;
+    };
+
+    // The subcommands are held by pointer so that the index can view their
+    // names
+    List<std::unique_ptr<CommandNode>> _commands;
+    Map<StringView, std::size_t, typename StringView::Hash> _command_index;
+    CommandNode *_selected;
+
+    // The rendered help, of which the usage is the first line.  It is only
+    // rendered again once the parser or, through the flag that they share in
+    // the arena, any of its nodes has changed.
+    mutable String _help_text;
+    mutable std::size_t _usage_size;
+    mutable bool _help_rendered;
+    bool *_nodes_changed;
+    std::size_t _help_width;
+
+    // The blob that the schema was loaded from, if it was, which the flag
+    // indices and the names and help of the nodes still to be bound view.
+    // Unbound nodes have no root or value, and every parse fails until
+    // there are none.
+    const unsigned char *_schema;
+    List<StringView> _schema_names;
+    List<StringView> _schema_help;
+    // The flags of each loaded option, gathered from the flag indices only
+    // once the help has to be rendered again, and the flags they view
+    mutable List<Flags> _schema_flags;
+    mutable List<Char> _schema_shorts;
+    mutable List<StringView> _schema_longs;
+    std::size_t _unbound;
+    std::size_t _option_cursor;
+    std::size_t _positional_cursor;
+
+    /** The state carried between chunks of a single parse
+     */
+    struct ParseState {
+        // Where values, matches, and errors go: either a Result, or the nodes
+        // themselves and the parser's own error when it is null
+        Result *result;
+        ParseError *error;
+        // Where the parse is counted, if anywhere
+        Stats *stats;
+        bool terminated;
+        // A value option that still needs its separate argument, and the flag
+        // it was matched through, which views the index key so that it stays
+        // valid after the chunk it came from is gone.
+        const Node *pending;
+        StringView pendingFlag;
+        bool pendingShort;
+        std::size_t pendingIndex;
+        // Index of the next positional that may receive a chunk.  It only
+        // ever moves forward, so filling N positionals is O(N) overall.
+        std::size_t positional;
+        // Index of the current chunk, counting each word of a command string
+        // or response file as one
+        std::size_t index;
+        // Whether the chunks come from a response file, whose views don't
+        // outlive the parse, and how deeply those files are nested
+        bool transient;
+        std::size_t depth;
+        // Whether a subcommand word stops the parse, and the subcommand and
+        // index of the word that did
+        bool dispatch;
+        CommandNode *command;
+        std::size_t commandIndex;
+
+        ParseState(ParseError &error, Stats *stats, Result *result = nullptr)
+            : result(result),
+              error(&error),
+              stats(stats),
+              terminated(false),
+              pending(nullptr),
+              pendingShort(false),
+              pendingIndex(0),
+              positional(0),
+              index(0),
+              transient(false),
+              depth(0),
+              dispatch(false),
+              command(nullptr),
+              commandIndex(0) {}
+    };
+
+    void Match(ParseState &state, const Node &node) const {
+        if (state.result) {
+            state.result->_matched[node.slot] = true;
+        } else if (_frozen) {
+            _matched_bits[node.slot / 64] |= std::uint64_t(1)
+                << (node.slot % 64);
+        } else {
+            node.root->SetMatched(true);
+        }
+    }
+
+    bool IsMatched(const ParseState &state, const Node &node) const {
+        if (state.result) {
+            return state.result->_matched[node.slot];
+        }
+        return _frozen
+            ? (_matched_bits[node.slot / 64] >> (node.slot % 64) & 1) != 0
+            : node.root->Matched();
+    }
+
+    /** Fail the parse with an error about the current argument
+     */
+    bool Fail(ParseState &state, const ErrorCode code, const StringView &span,
+        const Node *node = nullptr) const {
+        PhaseTimer timer(state.stats, Stats::Error);
+        Count(state.stats, &Stats::errors);
+        state.error->Assign(
+            code, state.index, node ? node->root : nullptr, span);
+        return false;
+    }
+
+    /** Convert a value into its node, or into the Result, or just record it
+     * when parsing lazily
+     *
+     * \return false, with the error set, if the value is invalid
+     */
+    bool Store(ParseState &state, const Node &node, const StringView &value,
+        const StringView &flag) const {
+        PhaseTimer timer(state.stats, Stats::Convert);
+        bool stored;
+        if (state.result) {
+            stored =
+                node.value->ParseSlot(state.result->Get(node.slot), value);
+        } else if (_lazy && !state.transient) {
+            node.value->Defer(Span{state.index, value, flag});
+            return true;
+        } else {
+            // Whatever was deferred comes first, so that a list stays in
+            // order and a scalar keeps the later value
+            Span failed;
+            if (_lazy && !node.value->Resolve(failed)) {
+                Count(state.stats, &Stats::errors);
+                state.error->Assign(ErrorCode::InvalidValue, failed.index,
+                    node.root, failed.flag);
+                return false;
+            }
+            stored = node.value->ParseValue(value);
+        }
+        Count(state.stats, &Stats::conversions);
+        return stored || Fail(state, ErrorCode::InvalidValue, flag, &node);
+    }
+
+    const ShortEntry *MatchOption(const Char flag) const {
+        return _short_table.Find(flag);
+    }
+
+    /** Add all of an option's flags to the flag index.
+     *
+     * A flag that is already owned by another option keeps pointing to the
+     * first option, and the conflict is recorded as a schema error, which
+     * makes every subsequent parse fail with that message.
+     */
+    void IndexOption(const OptionBase &option, const std::size_t index) {
+        const Flags &flags = option.GetFlags();
+        for (const Char flag : flags.shorts) {
+            if (!_short_table.Insert(flag, index)) {
+                _schema_error.assign("Flag '");
+                _schema_error.append(1, flag);
+                _schema_error.append(
+                    "' was registered to more than one option");
+                _error.Assign(ErrorCode::Schema, _schema_error);
+            }
+        }
+        for (std::size_t i = 0; i < flags.longCount; ++i) {
+            const StringView &flag = flags.longs[i];
+            if (!_long_trie.Insert(flag, index)) {
+                _schema_error.assign("Flag '");
+                _schema_error.append(flag.data(), flag.size());
+                _schema_error.append(
+                    "' was registered to more than one option");
+                _error.Assign(ErrorCode::Schema, _schema_error);
+            }
+        }
+    }
+
+    /** Parse a long flag chunk, with or without a joined value
+     */
+    bool ParseLong(ParseState &state, const StringView &chunk) const {
+        const StringView argchunk = chunk.substr(_long_prefix.size());
+        Count(state.stats, &Stats::lookups);
+        const typename LongTrie::Found found = [&] {
+            PhaseTimer timer(state.stats, Stats::Lookup);
+            return _long_trie.Find(argchunk, _long_separator, _abbreviate);
+        }();
+        if (found.option == LongTrie::None ||
+            found.option == LongTrie::Ambiguous) {
+            return Fail(state,
+                found.option == LongTrie::None ? ErrorCode::UnmatchedFlag
+                                               : ErrorCode::AmbiguousFlag,
+                argchunk.substr(0, found.length));
+        }
+        // The flag views the index rather than the chunk, and is the whole
+        // flag even if it was abbreviated
+        const StringView arg = found.flag;
+        const auto separator =
+            found.length == argchunk.size() ? StringView::npos : found.length;
+        const Node &option = _options[found.option];
+        Match(state, option);
+        if (option.value) {
+            if (separator != StringView::npos) {
+                if (!_joined_long) {
+                    return Fail(state, ErrorCode::JoinedArgument, arg, &option);
+                }
+                if (!Store(state, option,
+                        argchunk.substr(separator + _long_separator.size()),
+                        arg)) {
+                    return false;
+                }
+            } else {
+                state.pending = &option;
+                state.pendingFlag = arg;
+                state.pendingShort = false;
+                state.pendingIndex = state.index;
+            }
+        } else if (separator != StringView::npos) {
+            return Fail(state, ErrorCode::NonArgumentFlag, chunk, &option);
+        }
+        return true;
+    }
+
+    /** Parse a chunk of one or more short flags, the last of which may take a
+     * joined value
+     */
+    bool ParseShort(ParseState &state, const StringView &chunk) const {
+        const StringView argchunk = chunk.substr(_short_prefix.size());
+        for (std::size_t i = 0; i < argchunk.size(); ++i) {
+            Count(state.stats, &Stats::lookups);
+            const ShortEntry *const match = [&] {
+                PhaseTimer timer(state.stats, Stats::Lookup);
+                return MatchOption(argchunk[i]);
+            }();
+            if (!match) {
+                return Fail(
+                    state, ErrorCode::UnmatchedFlag, argchunk.substr(i, 1));
+            }
+            // The flag views the index rather than the chunk, so that
+            // errors and lazy values may outlive the arguments
+            const StringView arg = _short_table.View(*match);
+            const Node &option = _options[match->option];
+            Match(state, option);
+            if (option.value) {
+                const StringView value = argchunk.substr(i + 1);
+                if (!value.empty()) {
+                    if (!_joined_short) {
+                        return Fail(
+                            state, ErrorCode::JoinedArgument, arg, &option);
+                    }
+                    if (!Store(state, option, value, arg)) {
+                        return false;
+                    }
+                } else {
+                    state.pending = &option;
+                    state.pendingFlag = arg;
+                    state.pendingShort = true;
+                    state.pendingIndex = state.index;
+                }
+                // Because this argchunk is done regardless, because a value
+                // option flag was just encountered
+                break;
+            }
+        }
+        return true;
+    }
+
+    /** Feed the separate argument of the pending value option
+     */
+    bool ParseSeparateValue(ParseState &state, const StringView &chunk) const {
+        const Node &option = *state.pending;
+        state.pending = nullptr;
+        if (!(state.pendingShort ? _separate_short : _separate_long)) {
+            return Fail(
+                state, ErrorCode::SeparateArgument, state.pendingFlag, &option);
+        }
+        if (!Store(state, option, chunk, state.pendingFlag)) {
+            return false;
+        }
+        return true;
+    }
+
+    bool ParsePositional(ParseState &state, const StringView &chunk) const {
+        const Node *const pos = [&] {
+            PhaseTimer timer(state.stats, Stats::Positional);
+            return GetNextPositional(state);
+        }();
+        if (pos) {
+            Count(state.stats, &Stats::positionals);
+            if (!Store(state, *pos, chunk, StringView())) {
+                return false;
+            }
+            Match(state, *pos);
+            return true;
+        }
+        return Fail(state, ErrorCode::UnexpectedPositional, chunk);
+    }
+
+    enum class ChunkKind { Terminator, Long, Short, Positional };
+
+    /** Work out what a chunk is from its first few characters.
+     *
+     * The option terminator wins over the long prefix, which wins over the
+     * short prefix, and a prefix alone is a positional.  Only as many
+     * characters as the prefixes hold are ever looked at.
+     */
+    ChunkKind Classify(const StringView &chunk) const {
+        if (_dash_syntax) {
+            if (chunk.size() < 2 || chunk[0] != Char('-')) {
+                return ChunkKind::Positional;
+            }
+            if (chunk[1] != Char('-')) {
+                return ChunkKind::Short;
+            }
+            return chunk.size() == 2 ? ChunkKind::Terminator : ChunkKind::Long;
+        }
+        if (chunk == StringView(_option_terminator)) {
+            return ChunkKind::Terminator;
+        }
+        if (chunk.size() > _long_prefix.size() &&
+            chunk.StartsWith(_long_prefix)) {
+            return ChunkKind::Long;
+        }
+        if (chunk.size() > _short_prefix.size() &&
+            chunk.StartsWith(_short_prefix)) {
+            return ChunkKind::Short;
+        }
+        return ChunkKind::Positional;
+    }
+
+    /** Parse a single argument chunk, continuing from the given state
+     */
+    bool ParseChunk(ParseState &state, const StringView &chunk) const {
+        if (state.pending) {
+            return ParseSeparateValue(state, chunk);
+        }
+        if (!state.terminated) {
+            Count(state.stats, &Stats::chunks);
+            const ChunkKind kind = [&] {
+                PhaseTimer timer(state.stats, Stats::Classify);
+                return Classify(chunk);
+            }();
+            switch (kind) {
+                case ChunkKind::Terminator:
+                    state.terminated = true;
+                    return true;
+                case ChunkKind::Long: return ParseLong(state, chunk);
+                case ChunkKind::Short: return ParseShort(state, chunk);
+                case ChunkKind::Positional: break;
+            }
+            if (state.dispatch && state.depth == 0 &&
+                FindCommand(state, chunk)) {
+                return true;
+            }
+        }
+        return ParsePositional(state, chunk);
+    }
+
+    /** Select the subcommand that a chunk names, if any, which stops the
+     * parse at it
+     */
+    bool FindCommand(ParseState &state, const StringView &chunk) const {
+        const auto found = _command_index.find(chunk);
+        if (found == _command_index.end()) {
+            return false;
+        }
+        state.command = _commands[found->second].get();
+        state.commandIndex = state.index;
+        return true;
+    }
+
+    void UpdateSyntax() {
+        _dash_syntax = _long_prefix == String("--") &&
+            _short_prefix == String("-") && _option_terminator == String("--");
+    }
+
+    // Deep enough for any sane build, and shallow enough to stop a file that
+    // includes itself
+    static const std::size_t MaxResponseDepth = 32;
+
+    /** Parse the words of a response file, as they are read, as if they were
+     * arguments in place of it
+     */
+    bool ParseResponseFile(ParseState &state, const StringView &path) const {
+        if (state.depth == MaxResponseDepth) {
+            return Fail(state, ErrorCode::ResponseFileDepth, path);
+        }
+        const String name = path.str();
+        const MappedFile file(name.c_str());
+        if (!file.Valid()) {
+            return Fail(state, ErrorCode::UnreadableResponseFile, path);
+        }
+
+        const bool transient = state.transient;
+        state.transient = true;
+        ++state.depth;
+        Tokenizer words(file.View());
+        const bool parsed = ParseWords(state, words);
+        --state.depth;
+        state.transient = transient;
+        if (parsed && words.Unterminated()) {
+            return Fail(state, ErrorCode::UnterminatedResponseFile, path);
+        }
+        return parsed;
+    }
+
+    /** Parse each word of a Tokenizer as an argument as soon as it is split
+     */
+    bool ParseWords(ParseState &state, Tokenizer &words) const {
+        const bool transient = state.transient;
+        StringView word;
+        bool parsed = true;
+        while (parsed && !state.command && words.Next(word)) {
+            // Unescaped words are overwritten by the next one
+            state.transient = transient || words.Copied();
+            parsed = ParseArgument(state, word);
+            ++state.index;
+        }
+        state.transient = transient;
+        return parsed;
+    }
+
+    /** Parse a single argument, expanding it first if it names a response
+     * file, unless it is the value of a flag
+     */
+    bool ParseArgument(ParseState &state, const StringView &chunk) const {
+        if (_response_files && !state.terminated && !state.pending &&
+            chunk.size() > 1 && chunk[0] == Char('@')) {
+            return ParseResponseFile(state, chunk.substr(1));
+        }
+        return ParseChunk(state, chunk);
+    }
+
+    /** Finish a parse after the last chunk, which fails if a value option is
+     * still waiting for its argument
+     */
+    bool FinishParse(ParseState &state) const {
+        if (state.pending) {
+            Count(state.stats, &Stats::errors);
+            state.error->Assign(ErrorCode::MissingArgument, state.pendingIndex,
+                state.pending->root, state.pendingFlag);
+            return false;
+        }
+        return true;
+    }
+
+    /** Get the first positional that is still unmatched, or is a list, which
+     * absorbs every positional chunk from then on
+     */
+    const Node *GetNextPositional(ParseState &state) const {
+        for (; state.positional < _positionals.size(); ++state.positional) {
+            const Node &positional = _positionals[state.positional];
+            if (positional.list || !IsMatched(state, positional)) {
+                return &positional;
+            }
+        }
+        return nullptr;
+    }
+
+    /** Parse every chunk from begin to end into the state's target, or up
+     * to a subcommand word
+     *
+     * \param stop set to the chunk that failed or named a subcommand, or to
+     * end
+     */
+    template <typename It>
+    bool Parse(ParseState &state, It begin, It end, It &stop) const {
+        for (stop = begin; stop != end; ++stop, ++state.index) {
+            if (!ParseArgument(state, StringView(*stop))) {
+                return false;
+            }
+            if (state.command) {
+                break;
+            }
+        }
+        return FinishParse(state);
+    }
+
+    /** Build a subcommand's parser if it hasn't been yet
+     */
+    ArgumentParser &Build(CommandNode &command) {
+        if (!command.parser) {
+            command.parser.reset(
+                new ArgumentParser(command.help, String(), command.name));
+            command.parser->_stats = _stats;
+            command.factory(*command.parser);
+            if (_frozen) {
+                command.parser->Freeze();
+            }
+        }
+        return *command.parser;
+    }
+
+    ArgumentParser &Select(CommandNode &command) {
+        _selected = &command;
+        return Build(command);
+    }
+
+    /** Take the error of a subcommand, counting its index from the start of
+     * this parser's arguments
+     *
+     * \return false
+     */
+    bool Inherit(const ArgumentParser &child, const std::size_t offset) {
+        _error = child._error;
+        _error._index += offset;
+        return false;
+    }
+
+    /** Parse the rest of a command's words into this parser, and then into
+     * the subcommand that one of them names
+     */
+    bool ParseWords(Tokenizer &words) {
+        if (!Prepare()) {
+            return false;
+        }
+        ParseState state(_error, _stats);
+        state.dispatch = !_commands.empty();
+        if (!ParseCommand(state, words)) {
+            return false;
+        }
+        if (!state.command) {
+            return true;
+        }
+        ArgumentParser &child = Select(*state.command);
+        return child.ParseWords(words) ||
+            Inherit(child, state.commandIndex + 1);
+    }
+
+    /** Find a node that can't be converted, as it has neither a stream
+     * extraction operator nor a Converter, and describe it.  Only those
+     * nodes are checked, so a schema without them checks nothing.
+     */
+    bool Unconverted(String &error) const {
+        for (const Node &node : _unreadable) {
+            if (!node.value->Converts()) {
+                error.assign("'");
+                const StringView name = node.root->Name();
+                error.append(name.data(), name.size());
+                error.append(
+                    "' has no Converter, and its type can't be read from a "
+                    "stream");
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /** Get ready to parse into the nodes
+     *
+     * \return false, with the error set, if the schema is broken
+     */
+    bool Prepare() {
+        String unconverted;
+        if (!_schema_error.empty()) {
+            _error.Assign(ErrorCode::Schema, _schema_error);
+            return false;
+        }
+        if (Unconverted(unconverted)) {
+            _error.Assign(ErrorCode::Schema, unconverted);
+            return false;
+        }
+        if (_frozen) {
+            Reset();
+        }
+        _selected = nullptr;
+        return true;
+    }
+
+    /** Get ready to parse into a Result, which is reset first
+     */
+    bool Prepare(Result &result) const {
+        result.Reset();
+        String unconverted;
+        if (!_schema_error.empty()) {
+            result._error.Assign(ErrorCode::Schema, _schema_error);
+            return false;
+        }
+        if (Unconverted(unconverted)) {
+            result._error.Assign(ErrorCode::Schema, unconverted);
+            return false;
+        }
+        if (!_commands.empty()) {
+            result._error.Assign(ErrorCode::Schema,
+                "subcommands are not supported when parsing into a Result");
+            return false;
+        }
+        if (result._slots.size() != _storage.size()) {
+            result._error.Assign(
+                ErrorCode::ResultMismatch, 0, nullptr, StringView());
+            return false;
+        }
+        return true;
+    }
+
+    bool ParseCommand(ParseState &state, Tokenizer &words) const {
+        if (!ParseWords(state, words)) {
+            return false;
+        }
+        if (words.Unterminated()) {
+            return Fail(state, ErrorCode::UnterminatedCommand, StringView());
+        }
+        return FinishParse(state);
+    }
+
+    /** Append text, wrapped at spaces so that no line passes the help
+     * width, where every wrapped line is indented to the given column
+     *
+     * \param column the column that the text starts at
+     */
+    void AppendWrapped(const StringView &text, std::size_t column,
+        const std::size_t indent) const {
+        bool first = true;
+        for (std::size_t pos = 0; pos < text.size();) {
+            if (IsSpace(text[pos])) {
+                ++pos;
+                continue;
+            }
+            std::size_t end = pos;
+            while (end < text.size() && !IsSpace(text[end])) {
+                ++end;
+            }
+            if (!first && column + 1 + end - pos > _help_width) {
+                _help_text.append(1, Char('\n'));
+                _help_text.append(indent, Char(' '));
+                column = indent;
+            } else if (!first) {
+                _help_text.append(1, Char(' '));
+                ++column;
+            }
+            _help_text.append(text.data() + pos, end - pos);
+            column += end - pos;
+            first = false;
+            pos = end;
+        }
+    }
+
+    /** The width of the label of an option, which lists its flags, sorted
+     * so that the help is the same whatever order the Sets take, and its
+     * name
+     */
+    std::size_t LabelSize(const Flags &flags, const StringView &name) const {
+        const std::size_t count = flags.shorts.size() + flags.longCount;
+        std::size_t size = flags.shorts.size() * (_short_prefix.size() + 1) +
+            flags.longCount * _long_prefix.size() +
+            (count ? count - 1 : 0) * 2 + 1 + name.size();
+        for (std::size_t i = 0; i < flags.longCount; ++i) {
+            size += flags.longs[i].size();
+        }
+        return size;
+    }
+
+    /** Append the label of an option.  Its flags are unique and few, so
+     * each one is found in order by looking for the least after the last,
+     * which sorts them without a buffer.
+     */
+    void AppendLabel(const Flags &flags, const StringView &name) const {
+        bool first = true;
+        const Char *lastShort = nullptr;
+        for (std::size_t n = 0; n < flags.shorts.size(); ++n) {
+            const Char *next = nullptr;
+            for (const Char &flag : flags.shorts) {
+                if ((!lastShort || *lastShort < flag) &&
+                    (!next || flag < *next)) {
+                    next = &flag;
+                }
+            }
+            _help_text.append(first ? "" : ", ");
+            _help_text.append(_short_prefix);
+            _help_text.append(1, *next);
+            first = false;
+            lastShort = next;
+        }
+        // In the order of String's traits, as Strings compare
+        const auto less = [](const StringView &lhs, const StringView &rhs) {
+            const int order = String::traits_type::compare(
+                lhs.data(), rhs.data(), std::min(lhs.size(), rhs.size()));
+            return order < 0 || (order == 0 && lhs.size() < rhs.size());
+        };
+        const StringView *lastLong = nullptr;
+        for (std::size_t n = 0; n < flags.longCount; ++n) {
+            const StringView *next = nullptr;
+            for (std::size_t i = 0; i < flags.longCount; ++i) {
+                const StringView &flag = flags.longs[i];
+                if ((!lastLong || less(*lastLong, flag)) &&
+                    (!next || less(flag, *next))) {
+                    next = &flag;
+                }
+            }
+            _help_text.append(first ? "" : ", ");
+            _help_text.append(_long_prefix);
+            _help_text.append(next->data(), next->size());
+            first = false;
+            lastLong = next;
+        }
+        _help_text.append(" ");
+        _help_text.append(name.data(), name.size());
+    }
+
+    /** Append a section of the help, with a line for each entry, whose help
+     * is wrapped in a column of its own
+     */
+    template <typename Size, typename Label, typename Help>
+    void AppendSection(const char *title, const std::size_t count,
+        const Size &size, const Label &label, const Help &help) const {
+        if (count == 0) {
+            return;
+        }
+        std::size_t width = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            width = std::max(width, size(i));
+        }
+        // Labels that are too long push their help onto the next line
+        const std::size_t column = std::min(width + 4, _help_width / 2);
+        _help_text.append("\n");
+        _help_text.append(title);
+        _help_text.append(":\n");
+        for (std::size_t i = 0; i < count; ++i) {
+            _help_text.append("  ");
+            label(i);
+            const std::size_t end = 2 + size(i);
+            const StringView text = help(i);
+            if (!text.empty()) {
+                if (end + 2 > column) {
+                    _help_text.append("\n");
+                    _help_text.append(column, Char(' '));
+                } else {
+                    _help_text.append(column - end, Char(' '));
+                }
+                AppendWrapped(text, column, column);
+            }
+            _help_text.append("\n");
+        }
+    }
+
+    /** The name and help of a node, which are still in the blob if it belongs
+     * to a loaded schema and isn't bound yet
+     */
+    StringView NameOf(const Node &node) const {
+        return node.root ? StringView(node.root->Name())
+                         : _schema_names[node.slot];
+    }
+
+    StringView HelpOf(const Node &node) const {
+        return node.root ? StringView(node.root->Help())
+                         : _schema_help[node.slot];
+    }
+
+    /** The flags of an option, which for a loaded schema are only in the flag
+     * indices, so they are gathered by option the first time they are needed
+     */
+    const Flags &FlagsOf(const std::size_t option) const {
+        if (!_schema) {
+            return *_option_flags[option];
+        }
+        if (_schema_flags.empty() && !_options.empty()) {
+            List<ShortEntry> shorts;
+            _short_table.ForEach([&shorts](const ShortEntry &entry) {
+                shorts.push_back(entry);
+            });
+            List<std::pair<std::size_t, StringView>> longs;
+            _long_trie.Complete(StringView(),
+                [&longs](const StringView &flag, const std::size_t owner) {
+                    longs.emplace_back(owner, flag);
+                });
+            // Each option's flags are next to each other, in order of option
+            std::stable_sort(shorts.begin(), shorts.end(),
+                [](const ShortEntry &lhs, const ShortEntry &rhs) {
+                    return lhs.option < rhs.option;
+                });
+            std::stable_sort(longs.begin(), longs.end(),
+                [](const std::pair<std::size_t, StringView> &lhs,
+                    const std::pair<std::size_t, StringView> &rhs) {
+                    return lhs.first < rhs.first;
+                });
+            for (const ShortEntry &entry : shorts) {
+                _schema_shorts.push_back(entry.flag);
+            }
+            for (const auto &entry : longs) {
+                _schema_longs.push_back(entry.second);
+            }
+            std::size_t shortEnd = 0;
+            std::size_t longEnd = 0;
+            Reserve(_schema_flags, _options.size(), 0);
+            for (std::size_t i = 0; i < _options.size(); ++i) {
+                const std::size_t shortBegin = shortEnd;
+                const std::size_t longBegin = longEnd;
+                while (
+                    shortEnd < shorts.size() && shorts[shortEnd].option == i) {
+                    ++shortEnd;
+                }
+                while (longEnd < longs.size() && longs[longEnd].first == i) {
+                    ++longEnd;
+                }
+                _schema_flags.push_back(
+                    Flags{StringView(_schema_shorts.data() + shortBegin,
+                              shortEnd - shortBegin),
+                        _schema_longs.data() + longBegin, longEnd - longBegin});
+            }
+        }
+        return _schema_flags[option];
+    }
+
+    void RenderHelp() const {
+        _help_text.clear();
+        _help_text.append("Usage:");
+        if (!_prog.empty()) {
+            _help_text.append(" ");
+            _help_text.append(_prog);
+        }
+        if (!_options.empty()) {
+            _help_text.append(" [OPTIONS]");
+        }
+        for (const Node &node : _positionals) {
+            const StringView name = NameOf(node);
+            _help_text.append(" [");
+            _help_text.append(name.data(), name.size());
+            _help_text.append(node.list ? "...]" : "]");
+        }
+        if (!_commands.empty()) {
+            _help_text.append(" COMMAND");
+        }
+        _usage_size = _help_text.size();
+        _help_text.append("\n");
+        if (!_description.empty()) {
+            _help_text.append("\n");
+            AppendWrapped(_description, 0, 0);
+            _help_text.append("\n");
+        }
+        AppendSection("Options", _options.size(),
+            [this](std::size_t i) {
+                return LabelSize(FlagsOf(i), NameOf(_options[i]));
+            },
+            [this](std::size_t i) {
+                AppendLabel(FlagsOf(i), NameOf(_options[i]));
+            },
+            [this](std::size_t i) { return HelpOf(_options[i]); });
+        AppendSection("Positionals", _positionals.size(),
+            [this](std::size_t i) { return NameOf(_positionals[i]).size(); },
+            [this](std::size_t i) {
+                const StringView name = NameOf(_positionals[i]);
+                _help_text.append(name.data(), name.size());
+            },
+            [this](std::size_t i) { return HelpOf(_positionals[i]); });
+        AppendSection("Commands", _commands.size(),
+            [this](std::size_t i) { return _commands[i]->name.size(); },
+            [this](std::size_t i) { _help_text.append(_commands[i]->name); },
+            [this](std::size_t i) { return StringView(_commands[i]->help); });
+        if (!_epilog.empty()) {
+            _help_text.append("\n");
+            AppendWrapped(_epilog, 0, 0);
+            _help_text.append("\n");
+        }
+        _help_rendered = true;
+        if (_nodes_changed) {
+            *_nodes_changed = false;
+        }
+    }
+
+    /** The option that a long flag chunk leaves waiting for its separate
+     * argument, if any
+     */
+    const Node *PendingLong(const StringView &chunk) const {
+        const StringView argchunk = chunk.substr(_long_prefix.size());
+        const auto found =
+            _long_trie.Find(argchunk, _long_separator, _abbreviate);
+        if (found.option >= _options.size() ||
+            found.length != argchunk.size()) {
+            return nullptr;
+        }
+        const Node &option = _options[found.option];
+        return option.value && _separate_long ? &option : nullptr;
+    }
+
+    /** The option that a short flag chunk leaves waiting for its separate
+     * argument, if any
+     */
+    const Node *PendingShort(const StringView &chunk) const {
+        const StringView argchunk = chunk.substr(_short_prefix.size());
+        for (std::size_t i = 0; i < argchunk.size(); ++i) {
+            const ShortEntry *const match = MatchOption(argchunk[i]);
+            if (!match) {
+                return nullptr;
+            }
+            const Node &option = _options[match->option];
+            if (option.value) {
+                return i + 1 == argchunk.size() && _separate_short ? &option
+                                                                   : nullptr;
+            }
+        }
+        return nullptr;
+    }
+
+    static bool ViewLess(const StringView &lhs, const StringView &rhs) {
+        return std::lexicographical_compare(
+            lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+    }
+
+    /** Copy the flags that an option is added with into the arena, leaving
+     * out any that the initializer list repeats
+     */
+    Flags CopyFlags(const FlagSource &source) {
+        std::size_t shortCount = 0;
+        std::size_t longCount = 0;
+        source.ForEach([&shortCount](Char) { ++shortCount; },
+            [&longCount](const StringView &) { ++longCount; });
+        Char *const shorts = static_cast<Char *>(
+            _arena.Allocate(shortCount * sizeof(Char), alignof(Char)));
+        StringView *const longs = static_cast<StringView *>(_arena.Allocate(
+            longCount * sizeof(StringView), alignof(StringView)));
+        Flags flags{StringView(), longs, 0};
+        std::size_t shortSize = 0;
+        source.ForEach(
+            [shorts, &shortSize](const Char flag) {
+                if (std::find(shorts, shorts + shortSize, flag) ==
+                    shorts + shortSize) {
+                    shorts[shortSize++] = flag;
+                }
+            },
+            [this, longs, &flags](const StringView &flag) {
+                if (std::find(longs, longs + flags.longCount, flag) ==
+                    longs + flags.longCount) {
+                    new (longs + flags.longCount++)
+                        StringView(_arena.Copy(flag));
+                }
+            });
+        flags.shorts = StringView(shorts, shortSize);
+        return flags;
+    }
+
+    /** Construct a node in the arena and take ownership of it
+     */
+    template <typename T, typename... Args>
+    T *Construct(Args &&... args) {
+        _help_rendered = false;
+        _storage.push_back(nullptr);
+        return ConstructAt<T>(
+            _storage.size() - 1, std::forward<Args>(args)...);
+    }
+
+    /** Construct a node in the arena in a slot that is already in _storage
+     */
+    template <typename T, typename... Args>
+    T *ConstructAt(const std::size_t slot, Args &&... args) {
+        if (!_nodes_changed) {
+            _nodes_changed = new (_arena.Allocate(sizeof(bool), alignof(bool)))
+                bool(false);
+        }
+        void *memory = _arena.Allocate(sizeof(T), alignof(T));
+        if (Instrumented && _stats) {
+            _stats->bytes += sizeof(T);
+        }
+        T *node = new (memory) T(_arena.Self(), std::forward<Args>(args)...);
+        node->SetSlot(slot);
+        node->SetChanged(_nodes_changed);
+        if (_frozen) {
+            node->SetBits(_matched_bits.data());
+        }
+        _storage[slot] = node;
+        return node;
+    }
+
+    template <typename Value>
+    void NeedsConverter(const Node &node) {
+        if (!IsReadable<Value>::value) {
+            _unreadable.push_back(node);
+        }
+    }
+
+    /** Find the unbound node of a loaded schema with the name, looking after
+     * the last one bound first, since nodes are mostly bound in order
+     */
+    Node *FindUnbound(List<Node> &nodes, std::size_t &cursor,
+        const StringView &name, const bool list) {
+        for (std::size_t n = 0; n < nodes.size(); ++n) {
+            const std::size_t i = (cursor + n) % nodes.size();
+            Node &node = nodes[i];
+            if (!node.root && _schema_names[node.slot] == name) {
+                cursor = i + 1;
+                return node.list == list ? &node : nullptr;
+            }
+        }
+        return nullptr;
+    }
+
+    /** Take a node out of the unbound ones, letting the parser parse once
+     * it was the last
+     */
+    void Bound(Node &node, Root *root, ValueRoot *value) {
+        // The saved help is already in the help, so it isn't a change
+        root->SetChanged(nullptr);
+        root->SetHelp(_schema_help[node.slot]);
+        root->SetChanged(_nodes_changed);
+        node.root = root;
+        node.value = value;
+        if (--_unbound == 0 && _schema_error == UnboundError()) {
+            _schema_error.clear();
+            _error.Clear();
+        }
+    }
+
+    /** The number of slots of a Result, which has none while a loaded
+     * schema has unbound nodes, as every parse into it fails until then
+     */
+    std::size_t Slots() const { return _unbound ? 0 : _storage.size(); }
+
+    static const char *UnboundError() {
+        return "Every option and positional of a loaded schema must be bound";
+    }
+
+    void LoadFailed(const char *message) {
+        _schema_error.assign(message);
+        _error.Assign(ErrorCode::Schema, _schema_error);
+    }
+
+    // "argsplus" on a little-endian host, so that a blob saved with the
+    // other byte order never loads
+    static const std::uint64_t SchemaMagic = 0x73756c7073677261ULL;
+    static const std::uint64_t SchemaVersion = 2;
+
+    /** FNV-1a, which is enough to catch a blob that was damaged or cut short
+     */
+    static std::uint64_t Checksum(
+        const unsigned char *begin, const unsigned char *end) {
+        std::uint64_t hash = 0xcbf29ce484222325ULL;
+        for (; begin != end; ++begin) {
+            hash = (hash ^ *begin) * 0x100000001b3ULL;
+        }
+        return hash;
+    }
+
+    ArgumentParser(const ArgumentParser &) = delete;
+    ArgumentParser &operator=(const ArgumentParser &) = delete;
+
+    public:
+    ArgumentParser(const String &description = String{},
+        const String &epilog = String{}, const String &prog = String{})
+        : _prog(prog),
+          _description(description),
+          _epilog(epilog),
+          _long_prefix("--"),
+          _short_prefix("-"),
+          _long_separator("="),
+          _option_terminator("--"),
+          _dash_syntax(true),
+          _joined_short(true),
+          _joined_long(true),
+          _separate_short(true),
+          _separate_long(true),
+          _frozen(false),
+          _lazy(false),
+          _response_files(false),
+          _abbreviate(false),
+          _stats(nullptr),
+          _selected(nullptr),
+          _usage_size(0),
+          _help_rendered(false),
+          _nodes_changed(nullptr),
+          _help_width(80),
+          _schema(nullptr),
+          _unbound(0),
+          _option_cursor(0),
+          _positional_cursor(0) {}
+
+    ArgumentParser(ArgumentParser &&other) = default;
+    ArgumentParser &operator=(ArgumentParser &&) = delete;
+
+    ~ArgumentParser() {
+        for (auto it = _storage.rbegin(); it != _storage.rend(); ++it) {
+            if (*it) {
+                (*it)->~Root();
+            }
+        }
+    }
+
+    /** Record that the schema was changed after Freeze()
+     */
+    void CheckNotFrozen() {
+        if (_frozen) {
+            _schema_error.assign(
+                "Options and positionals may not be added to a frozen parser");
+            _error.Assign(ErrorCode::Schema, _schema_error);
+        }
+    }
+
+    /** Freeze the schema, making the parser reusable.
+     *
+     * A frozen parser may not have options or positionals added to it, and it
+     * calls Reset() at the start of every parse, so the same parser can parse
+     * any number of command lines.  Values keep the storage they have already
+     * allocated, so once it has warmed up, a successful parse of similar
+     * arguments makes no allocations, other than for new list elements that
+     * allocate storage of their own.
+     */
+    ArgumentParser &Freeze() {
+        if (!_frozen) {
+            _matched_bits.assign((_storage.size() + 63) / 64, 0);
+            for (Root *root : _storage) {
+                root->SetBits(_matched_bits.data());
+            }
+            _frozen = true;
+        }
+        // So that threads sharing the parser only ever read the help
+        Help();
+        return *this;
+    }
+
+    bool Frozen() const { return _frozen; }
+
+    /** Save the frozen schema as a compact blob: the settings, the rendered
+     * help, the name, help and kind of every option and positional, and the
+     * flag indices, which is all that a parser needs that isn't code.
+     *
+     * The blob is in the byte order and Char width of the host, and may be
+     * written to a file, or embedded in a program, to be loaded with
+     * LoadSchema() instead of building the schema again.
+     *
+     * \return false if the parser isn't frozen, has a schema error, or has
+     * subcommands, whose factories can't be saved
+     */
+    bool SaveSchema(List<unsigned char> &blob) const {
+        if (!_frozen || !_schema_error.empty() || !_commands.empty()) {
+            return false;
+        }
+        blob.clear();
+        SchemaWriter writer(blob);
+        writer.Integer(SchemaMagic);
+        writer.Integer(SchemaVersion << 32 | sizeof(Char));
+        // Filled in with the checksum of everything after it
+        writer.Integer(0);
+        const std::size_t header = blob.size();
+
+        for (const String *text : {&_prog, &_description, &_epilog,
+                 &_long_prefix, &_short_prefix, &_long_separator,
+                 &_option_terminator, &Help()}) {
+            writer.Text(*text);
+        }
+        writer.Integer(_usage_size);
+        writer.Integer(_help_width);
+        std::uint64_t settings = 0;
+        const bool *flags[] = {&_joined_short, &_joined_long, &_separate_short,
+            &_separate_long, &_lazy, &_response_files, &_abbreviate};
+        for (std::size_t i = 0; i < sizeof(flags) / sizeof(*flags); ++i) {
+            settings |= std::uint64_t(*flags[i]) << i;
+        }
+        writer.Integer(settings);
+
+        // Each slot is either an option or a positional, and is a list or not
+        List<unsigned char> kinds(_storage.size());
+        for (const Node &node : _options) {
+            kinds[node.slot] = node.list ? 1 : 0;
+        }
+        for (const Node &node : _positionals) {
+            kinds[node.slot] = node.list ? 3 : 2;
+        }
+        writer.Integer(_storage.size());
+        for (std::size_t slot = 0; slot < _storage.size(); ++slot) {
+            writer.Integer(kinds[slot]);
+            writer.Text(_storage[slot]->Name());
+            writer.Text(_storage[slot]->Help());
+        }
+
+        _long_trie.Save(writer);
+        std::size_t shorts = 0;
+        _short_table.ForEach([&shorts](const ShortEntry &) { ++shorts; });
+        writer.Integer(shorts);
+        _short_table.ForEach([&writer](const ShortEntry &entry) {
+            writer.Integer(static_cast<std::uint64_t>(entry.flag));
+            writer.Integer(entry.option);
+        });
+
+        const std::uint64_t checksum =
+            Checksum(blob.data() + header, blob.data() + blob.size());
+        std::memcpy(blob.data() + header - sizeof(checksum), &checksum,
+            sizeof(checksum));
+        return true;
+    }
+
+    /** Load a schema saved by SaveSchema() into this parser, which must be
+     * new.
+     *
+     * The flag indices are read in bulk and their flags, like the names of
+     * the nodes, are viewed in the blob, so loading allocates a few buffers
+     * however large the schema is, and the blob must outlive the parser.  It
+     * must be aligned for Char, as a memory-mapped file always is.
+     *
+     * The parser is frozen, and every parse into it fails until each of its
+     * options and positionals is bound to a typed handle with BindOption()
+     * or BindPositional().  Its help is the one that was saved, and bound
+     * nodes are given their saved help.  It's rendered again from the schema
+     * only once something it shows changes, like the help width or the help
+     * of a bound node.
+     *
+     * \return false if the blob wasn't saved by this version of the library
+     * on this kind of host, or is damaged, or the parser isn't new, all of
+     * which are schema errors
+     */
+    bool LoadSchema(const void *data, const std::size_t size) {
+        if (!_storage.empty() || !_commands.empty() || _frozen) {
+            LoadFailed("A schema may only be loaded into a new parser");
+            return false;
+        }
+        const unsigned char *const begin =
+            static_cast<const unsigned char *>(data);
+        SchemaReader reader(begin, begin + size);
+        const std::uint64_t magic = reader.Integer();
+        const std::uint64_t version = reader.Integer();
+        const std::uint64_t checksum = reader.Integer();
+        if (!reader.Valid() || magic != SchemaMagic ||
+            version != (SchemaVersion << 32 | sizeof(Char)) ||
+            reinterpret_cast<std::uintptr_t>(data) % alignof(Char) != 0 ||
+            checksum != Checksum(begin + 3 * sizeof(std::uint64_t),
+                            begin + size)) {
+            LoadFailed("The schema blob is not one that this parser can load");
+            return false;
+        }
+
+        for (String *text : {&_prog, &_description, &_epilog, &_long_prefix,
+                 &_short_prefix, &_long_separator, &_option_terminator,
+                 &_help_text}) {
+            const StringView view = reader.Text();
+            text->assign(view.data(), view.size());
+        }
+        _usage_size = reader.Index(_help_text.size() + 1);
+        _help_width = reader.Index(std::numeric_limits<std::size_t>::max());
+        const std::uint64_t settings = reader.Integer();
+        bool *flags[] = {&_joined_short, &_joined_long, &_separate_short,
+            &_separate_long, &_lazy, &_response_files, &_abbreviate};
+        for (std::size_t i = 0; i < sizeof(flags) / sizeof(*flags); ++i) {
+            *flags[i] = (settings >> i & 1) != 0;
+        }
+        UpdateSyntax();
+
+        const std::size_t count = reader.Index(size / sizeof(std::uint64_t));
+        if (reader.Valid()) {
+            _storage.assign(count, nullptr);
+            _schema_names.resize(count);
+            _schema_help.resize(count);
+            Reserve(_options, count, 0);
+            Reserve(_positionals, count, 0);
+        }
+        for (std::size_t slot = 0; reader.Valid() && slot < count; ++slot) {
+            const std::size_t kind = reader.Index(4);
+            _schema_names[slot] = reader.Text();
+            _schema_help[slot] = reader.Text();
+            List<Node> &nodes = kind < 2 ? _options : _positionals;
+            nodes.push_back(Node{nullptr, nullptr, (kind & 1) != 0, slot});
+        }
+
+        _long_trie.Load(reader, _options.size());
+        const std::size_t shorts = reader.Index(size);
+        for (std::size_t i = 0; reader.Valid() && i < shorts; ++i) {
+            const Char flag = static_cast<Char>(reader.Integer());
+            if (!_short_table.Insert(flag, reader.Index(_options.size()))) {
+                reader.Invalidate();
+            }
+        }
+        if (!reader.Valid() || !reader.AtEnd()) {
+            LoadFailed("The schema blob is not one that this parser can load");
+            return false;
+        }
+
+        _schema = begin;
+        _help_rendered = true;
+        _matched_bits.assign((_storage.size() + 63) / 64, 0);
+        _frozen = true;
+        _unbound = count;
+        if (_unbound) {
+            LoadFailed(UnboundError());
+        }
+        return true;
+    }
+
+    /** Bind the loaded option with the name to a handle of its value type,
+     * which must be a list if the saved option was.
+     *
+     * \return the handle, or null if there is no unbound option of the name
+     * that may take the type
+     */
+    template <typename Value>
+    Option<Value> *BindOption(const StringView &name) {
+        static_assert(IsReadable<Value>::value,
+            "values that can't be read from a stream need a Converter");
+        return BindOption<Value>(name, nullptr);
+    }
+
+    /** Bind the loaded option with the name, as BindOption(name), to a
+     * handle that converts its values with the Converter
+     */
+    template <typename Value>
+    Option<Value> *BindOption(
+        const StringView &name, const Converter<Value> &converter) {
+        Node *const node = FindUnbound(
+            _options, _option_cursor, name, IsList<Value>::value);
+        if (!node) {
+            return nullptr;
+        }
+        // The flags are already in the indices, so the option has none
+        auto opt = ConstructAt<Option<Value>>(
+            node->slot, name, Flags{StringView(), nullptr, 0});
+        opt->Convert(converter);
+        Bound(*node, opt, opt);
+        NeedsConverter<Value>(*node);
+        return opt;
+    }
+
+    /** Bind the loaded positional with the name to a handle of its value
+     * type, which must be a list if the saved positional was.
+     *
+     * \return the handle, or null if there is no unbound positional of the
+     * name that may take the type
+     */
+    template <typename Value>
+    Positional<Value> *BindPositional(const StringView &name) {
+        static_assert(IsReadable<Value>::value,
+            "values that can't be read from a stream need a Converter");
+        return BindPositional<Value>(name, nullptr);
+    }
+
+    /** Bind the loaded positional with the name, as BindPositional(name), to
+     * a handle that converts its values with the Converter
+     */
+    template <typename Value>
+    Positional<Value> *BindPositional(
+        const StringView &name, const Converter<Value> &converter) {
+        Node *const node = FindUnbound(
+            _positionals, _positional_cursor, name, IsList<Value>::value);
+        if (!node) {
+            return nullptr;
+        }
+        auto pos = ConstructAt<Positional<Value>>(node->slot, name);
+        pos->Convert(converter);
+        Bound(*node, pos, pos);
+        NeedsConverter<Value>(*node);
+        return pos;
+    }
+
+    /** Set the prefix of long flags, which is "--" by default
+     */
+    ArgumentParser &LongPrefix(const String &prefix) {
+        _long_prefix = prefix;
+        _help_rendered = false;
+        UpdateSyntax();
+        return *this;
+    }
+
+    const String &LongPrefix() const { return _long_prefix; }
+
+    /** Set the prefix of short flags, which is "-" by default
+     */
+    ArgumentParser &ShortPrefix(const String &prefix) {
+        _short_prefix = prefix;
+        _help_rendered = false;
+        UpdateSyntax();
+        return *this;
+    }
+
+    const String &ShortPrefix() const { return _short_prefix; }
+
+    /** Set what separates a long flag from its joined value, which is "=" by
+     * default.  If it is empty, long flags never take joined values.
+     */
+    ArgumentParser &LongSeparator(const String &separator) {
+        _long_separator = separator;
+        return *this;
+    }
+
+    const String &LongSeparator() const { return _long_separator; }
+
+    /** Set the argument that makes every argument after it a positional,
+     * which is "--" by default
+     */
+    ArgumentParser &OptionTerminator(const String &terminator) {
+        _option_terminator = terminator;
+        UpdateSyntax();
+        return *this;
+    }
+
+    const String &OptionTerminator() const { return _option_terminator; }
+
+    /** Accept any prefix of a long flag that no other option's long flags
+     * share, as GNU getopt_long does, so that --verb may mean --verbose.
+     *
+     * A prefix that is shared fails as ambiguous, and a whole flag always
+     * matches itself, even if it is also a prefix of another.
+     */
+    ArgumentParser &Abbreviations(const bool abbreviate) {
+        _abbreviate = abbreviate;
+        return *this;
+    }
+
+    bool Abbreviations() const { return _abbreviate; }
+
+    /** Allow short flags to take values joined to them, as in -n5, which is
+     * the default
+     */
+    ArgumentParser &JoinedShort(const bool allow) {
+        _joined_short = allow;
+        return *this;
+    }
+
+    bool JoinedShort() const { return _joined_short; }
+
+    /** Allow long flags to take values after the separator, as in
+     * --number=5, which is the default
+     */
+    ArgumentParser &JoinedLong(const bool allow) {
+        _joined_long = allow;
+        return *this;
+    }
+
+    bool JoinedLong() const { return _joined_long; }
+
+    /** Allow short flags to take their values from the next argument, as in
+     * -n 5, which is the default
+     */
+    ArgumentParser &SeparateShort(const bool allow) {
+        _separate_short = allow;
+        return *this;
+    }
+
+    bool SeparateShort() const { return _separate_short; }
+
+    /** Allow long flags to take their values from the next argument, as in
+     * --number 5, which is the default
+     */
+    ArgumentParser &SeparateLong(const bool allow) {
+        _separate_long = allow;
+        return *this;
+    }
+
+    bool SeparateLong() const { return _separate_long; }
+
+    /** Parse values lazily.
+     *
+     * A lazy parser only records where each value is in the arguments, and
+     * converts it on the first call to its Value().  Values that are never
+     * read, or that are replaced by a later occurrence of the same flag, are
+     * never converted, so they are never checked either, unless Validate() is
+     * called.  The arguments must outlive the lazy values.
+     *
+     * This only applies to parsing into the nodes; a Result is always filled
+     * in eagerly, and so are values that come from response files.
+     */
+    ArgumentParser &Lazy(const bool lazy) {
+        _lazy = lazy;
+        return *this;
+    }
+
+    bool Lazy() const { return _lazy; }
+
+    /** Expand arguments of the form \@file into the words of that file.
+     *
+     * The file is memory-mapped and split into words as they are parsed,
+     * with the quoting of Tokenizer, so the words are never gathered into a
+     * list.  Response files may name other response files.  Arguments after
+     * the option terminator, and separate values of flags, are never
+     * expanded.
+     */
+    ArgumentParser &ResponseFiles(const bool expand) {
+        _response_files = expand;
+        return *this;
+    }
+
+    bool ResponseFiles() const { return _response_files; }
+
+    /** Count every parse into the parser, and every node added to it, in the
+     * given Stats, or in none if it is null.
+     *
+     * This may be done whether or not the parser is frozen.  Parses into a
+     * Result are counted in the Stats of the Result instead.
+     */
+    ArgumentParser &Instrument(Stats *stats) {
+        _stats = stats;
+        return *this;
+    }
+
+    Stats *Instrumentation() const { return _stats; }
+
+    /** Convert every value that was parsed lazily.
+     *
+     * \return false if any fails, with the error that an eager parse would
+     * have given for the earliest failing argument
+     */
+    bool Validate() {
+        const Node *failedNode = nullptr;
+        Span failed;
+        for (const List<Node> *nodes : {&_options, &_positionals}) {
+            for (const Node &node : *nodes) {
+                Span span;
+                if (node.value && !node.value->Resolve(span) &&
+                    (!failedNode || span.index < failed.index)) {
+                    failedNode = &node;
+                    failed = span;
+                }
+            }
+        }
+        if (!failedNode) {
+            return true;
+        }
+        _error.Assign(ErrorCode::InvalidValue, failed.index, failedNode->root,
+            failed.flag);
+        return false;
+    }
+
+    /** Convert every value that was parsed lazily with up to the given number
+     * of threads.
+     *
+     * Nodes are converted independently of each other, and a list of many
+     * values is converted in pieces that are joined back in order, so the
+     * values and the error are exactly those that Validate() would give.
+     */
+    bool Validate(const unsigned threads) {
+        if (threads <= 1) {
+            return Validate();
+        }
+        struct Piece {
+            const Node *node;
+            std::size_t piece;
+            bool valid;
+            Span failed;
+        };
+        List<Piece> pieces;
+        for (const List<Node> *nodes : {&_options, &_positionals}) {
+            for (const Node &node : *nodes) {
+                const std::size_t count =
+                    node.value ? node.value->SplitDeferred(threads) : 0;
+                for (std::size_t i = 0; i < count; ++i) {
+                    pieces.push_back(Piece{&node, i, true, Span()});
+                }
+            }
+        }
+
+        std::atomic<std::size_t> next(0);
+        const auto work = [&pieces, &next] {
+            for (std::size_t i; (i = next++) < pieces.size();) {
+                Piece &piece = pieces[i];
+                piece.valid =
+                    piece.node->value->ResolvePiece(piece.piece, piece.failed);
+            }
+        };
+        List<std::thread> workers;
+        for (unsigned i = 1; i < threads && i < pieces.size(); ++i) {
+            workers.emplace_back(work);
+        }
+        work();
+        for (std::thread &worker : workers) {
+            worker.join();
+        }
+
+        // A node's pieces are in order, so its first failing piece holds its
+        // earliest failure, and the pieces after it are dropped as the
+        // sequential conversion would never have reached them
+        const Node *failedNode = nullptr;
+        Span failed;
+        for (std::size_t i = 0; i < pieces.size();) {
+            const Node &node = *pieces[i].node;
+            std::size_t joined = 0;
+            bool valid = true;
+            for (; i < pieces.size() && pieces[i].node == &node; ++i) {
+                if (!valid) {
+                    continue;
+                }
+                ++joined;
+                valid = pieces[i].valid;
+                if (!valid &&
+                    (!failedNode || pieces[i].failed.index < failed.index)) {
+                    failedNode = &node;
+                    failed = pieces[i].failed;
+                }
+            }
+            node.value->JoinPieces(joined);
+        }
+        if (!failedNode) {
+            return true;
+        }
+        _error.Assign(ErrorCode::InvalidValue, failed.index, failedNode->root,
+            failed.flag);
+        return false;
+    }
+
+    /** Restore every value to its default, mark everything unmatched, and
+     * clear the error
+     */
+    void Reset() {
+        if (_frozen) {
+            std::fill(_matched_bits.begin(), _matched_bits.end(), 0);
+        }
+        for (const List<Node> *nodes : {&_options, &_positionals}) {
+            for (const Node &node : *nodes) {
+                if (!node.root) {
+                    continue;
+                }
+                if (!_frozen) {
+                    node.root->SetMatched(false);
+                }
+                node.value->Reset();
+            }
+        }
+        _error.Clear();
+    }
+
+    /** Add an option, whose values are read with ExtractValue unless it is
+     * given a Converter.  Types that can't be read from a stream must be
+     * added with their Converter instead, so they don't compile here.
+     */
+    template <typename Value>
+    Option<Value> &AddOption(const StringView &name, const FlagSource &flags) {
+        static_assert(IsReadable<Value>::value,
+            "values that can't be read from a stream need a Converter");
+        return AddOption<Value>(name, flags, nullptr);
+    }
+
+    /** Add an option whose values are converted with the Converter
+     */
+    template <typename Value>
+    Option<Value> &AddOption(const StringView &name, const FlagSource &flags,
+        const Converter<Value> &converter) {
+        CheckNotFrozen();
+        // Create an option object in the arena, add it to the option array,
+        // then return a reference to it.
+        auto opt = Construct<Option<Value>>(name, CopyFlags(flags));
+        opt->Convert(converter);
+        IndexOption(*opt, _options.size());
+        _option_flags.push_back(&opt->GetFlags());
+        _options.push_back(
+            Node{opt, opt, IsList<Value>::value, opt->Slot()});
+        NeedsConverter<Value>(_options.back());
+        return *opt;
+    }
+
+    /** Add a positional, whose values are read with ExtractValue unless it
+     * is given a Converter.  Types that can't be read from a stream must be
+     * added with their Converter instead, so they don't compile here.
+     */
+    template <typename Value>
+    Positional<Value> &AddPositional(const StringView &name) {
+        static_assert(IsReadable<Value>::value,
+            "values that can't be read from a stream need a Converter");
+        return AddPositional<Value>(name, nullptr);
+    }
+
+    /** Add a positional whose values are converted with the Converter
+     */
+    template <typename Value>
+    Positional<Value> &AddPositional(
+        const StringView &name, const Converter<Value> &converter) {
+        CheckNotFrozen();
+        auto pos = Construct<Positional<Value>>(name);
+        pos->Convert(converter);
+        _positionals.push_back(
+            Node{pos, pos, IsList<Value>::value, pos->Slot()});
+        NeedsConverter<Value>(_positionals.back());
+        return *pos;
+    }
+
+    /** Add a subcommand, which takes every argument after the word that
+     * names it.
+     *
+     * The subcommand's parser is only built once the subcommand is first
+     * selected, by calling the factory with it to add its options and
+     * positionals, so that a tool with many subcommands only ever builds the
+     * ones it runs.  It is frozen when it is built if this parser is.
+     *
+     * A subcommand is selected by a positional word of the arguments, or of
+     * a command string, that names it, other than after the option
+     * terminator or in a response file.  Parses into a Result take command
+     * words as positionals like any other.
+     */
+    ArgumentParser &AddCommand(const String &name,
+        std::function<void(ArgumentParser &)> factory,
+        const String &help = String()) {
+        CheckNotFrozen();
+        _commands.emplace_back(new CommandNode{
+            name, help, std::move(factory), std::unique_ptr<ArgumentParser>()});
+        if (!_command_index
+                 .emplace(StringView(_commands.back()->name),
+                     _commands.size() - 1)
+                 .second) {
+            _schema_error.assign("Command '");
+            _schema_error.append(name);
+            _schema_error.append("' was registered more than once");
+            _error.Assign(ErrorCode::Schema, _schema_error);
+        }
+        _help_rendered = false;
+        return *this;
+    }
+
+    /** Get the parser of a subcommand, building it if it hasn't been yet
+     *
+     * \return null if there is no such subcommand
+     */
+    ArgumentParser *Command(const StringView &name) {
+        const auto found = _command_index.find(name);
+        if (found == _command_index.end()) {
+            return nullptr;
+        }
+        return &Build(*_commands[found->second]);
+    }
+
+    /** The parser of the subcommand that the last parse selected, if any
+     */
+    ArgumentParser *Selected() const {
+        return _selected ? _selected->parser.get() : nullptr;
+    }
+
+    /** The program name, which for a subcommand is its name
+     */
+    const String &Prog() const { return _prog; }
+
+    /** Set the width that help text is wrapped to, which is 80 by default
+     */
+    ArgumentParser &HelpWidth(const std::size_t width) {
+        _help_width = width;
+        _help_rendered = false;
+        return *this;
+    }
+
+    std::size_t HelpWidth() const { return _help_width; }
+
+    /** Get the help: the usage line, the description, a section each for
+     * the options, positionals, and subcommands, and the epilog.
+     *
+     * The help is rendered once, and only again after something it shows has
+     * changed, such as a node being added or given new help.  Freeze()
+     * renders it, so that a frozen parser may be asked for its help from
+     * several threads, unless a node's name or help changes after that.
+     */
+    const String &Help() const {
+        if (!_help_rendered || (_nodes_changed && *_nodes_changed)) {
+            RenderHelp();
+        }
+        return _help_text;
+    }
+
+    /** Get the usage line, which is the start of the help
+     */
+    StringView Usage() const {
+        return StringView(Help()).substr(0, _usage_size);
+    }
+
+    /** Write the help to a stream in one write
+     */
+    std::basic_ostream<Char> &WriteHelp(std::basic_ostream<Char> &out) const {
+        const String &help = Help();
+        return out.write(help.data(), help.size());
+    }
+
+    /** The ways that the word under the cursor of a partial command line can
+     * be completed, as found by Complete()
+     */
+    struct Completion {
+        // The long flags that the word begins, without their prefix, sorted
+        List<StringView> longFlags;
+        // The short flags that the word may be, sorted
+        List<Char> shortFlags;
+        // The subcommands that the word begins
+        List<StringView> commands;
+        // The option whose value the word is, if it is a value
+        const Root *option;
+        // The positional that the word would be, if it is a positional
+        const Root *positional;
+        // The parser, or subcommand parser, that the word belongs to
+        ArgumentParser *parser;
+
+        Completion() : option(nullptr), positional(nullptr), parser(nullptr) {}
+
+        void Clear() {
+            longFlags.clear();
+            shortFlags.clear();
+            commands.clear();
+            option = nullptr;
+            positional = nullptr;
+            parser = nullptr;
+        }
+    };
+
+    /** Work out how the word under the cursor can be completed, from the
+     * arguments before it, without converting any values.
+     *
+     * Flags are found by walking the flag indices from the word, so that
+     * this takes time in the number of candidates rather than of options,
+     * and a Completion that is reused only allocates when its lists grow.  A
+     * subcommand named by an earlier argument is built, if it hasn't been,
+     * and completes the rest.
+     *
+     * \param begin an iterator to the first argument, after the program name
+     * \param end an iterator to the argument under the cursor, or the end
+     * \param word the partial word under the cursor, which may be empty
+     * \param completion what the word may be, cleared first
+     */
+    template <typename It>
+    void Complete(It begin, It end, const StringView &word,
+        Completion &completion) {
+        completion.Clear();
+        completion.parser = this;
+        const Node *pending = nullptr;
+        bool terminated = false;
+        std::size_t positional = 0;
+        for (It it = begin; it != end; ++it) {
+            const StringView arg(*it);
+            if (pending) {
+                pending = nullptr;
+                continue;
+            }
+            if (!terminated) {
+                switch (Classify(arg)) {
+                    case ChunkKind::Terminator:
+                        terminated = true;
+                        continue;
+                    case ChunkKind::Long:
+                        pending = PendingLong(arg);
+                        continue;
+                    case ChunkKind::Short:
+                        pending = PendingShort(arg);
+                        continue;
+                    case ChunkKind::Positional: break;
+                }
+                const auto found = _command_index.find(arg);
+                if (found != _command_index.end()) {
+                    Build(*_commands[found->second])
+                        .Complete(std::next(it), end, word, completion);
+                    return;
+                }
+            }
+            if (positional < _positionals.size() &&
+                !_positionals[positional].list) {
+                ++positional;
+            }
+        }
+        if (pending) {
+            completion.option = pending->root;
+            return;
+        }
+
+        const auto addLong = [&completion](
+            const StringView &flag, std::size_t) {
+            completion.longFlags.push_back(flag);
+        };
+        const ChunkKind kind = terminated ? ChunkKind::Positional
+                                          : Classify(word);
+        // A word that is only the start of a prefix may become any flag
+        if (!terminated && !word.empty()) {
+            if (StringView(_long_prefix).StartsWith(word)) {
+                _long_trie.Complete(StringView(), addLong);
+            }
+            if (StringView(_short_prefix).StartsWith(word)) {
+                _short_table.ForEach([&completion](const ShortEntry &entry) {
+                    completion.shortFlags.push_back(entry.flag);
+                });
+            }
+        }
+        if (kind == ChunkKind::Long) {
+            const StringView rest = word.substr(_long_prefix.size());
+            if (!_long_separator.empty() &&
+                rest.find(_long_separator) != StringView::npos) {
+                const auto found =
+                    _long_trie.Find(rest, _long_separator, _abbreviate);
+                if (found.option < _options.size()) {
+                    completion.option = _options[found.option].root;
+                }
+                return;
+            }
+            _long_trie.Complete(rest, addLong);
+        } else if (kind == ChunkKind::Short) {
+            const StringView rest = word.substr(_short_prefix.size());
+            if (const ShortEntry *const match = MatchOption(rest[0])) {
+                if (rest.size() == 1) {
+                    completion.shortFlags.push_back(match->flag);
+                } else if (_options[match->option].value) {
+                    completion.option = _options[match->option].root;
+                    return;
+                }
+            }
+        } else if (kind == ChunkKind::Positional) {
+            if (positional < _positionals.size()) {
+                completion.positional = _positionals[positional].root;
+            }
+            for (const std::unique_ptr<CommandNode> &command : _commands) {
+                if (!terminated && StringView(command->name).StartsWith(word)) {
+                    completion.commands.push_back(StringView(command->name));
+                }
+            }
+        }
+        std::sort(completion.longFlags.begin(), completion.longFlags.end(),
+            &ViewLess);
+        std::sort(completion.shortFlags.begin(), completion.shortFlags.end());
+        std::sort(
+            completion.commands.begin(), completion.commands.end(), &ViewLess);
+    }
+
+    template <typename T>
+    void Complete(
+        const T &args, const StringView &word, Completion &completion) {
+        Complete(std::begin(args), std::end(args), word, completion);
+    }
+
+    /** Copy as much of the help as fits into a buffer, which is not
+     * terminated
+     *
+     * \return the size of the whole help, which may be more than was copied
+     */
+    std::size_t WriteHelp(Char *buffer, const std::size_t size) const {
+        const String &help = Help();
+        std::copy_n(help.data(), std::min(size, help.size()), buffer);
+        return help.size();
+    }
+
+    /** Parse all arguments, and then those after a subcommand word into the
+     * subcommand.
+     *
+     * \param begin an iterator to the beginning of the argument list
+     * \param end an iterator to the past-the-end element of the argument list
+     * \param stop set to the argument that failed, or to end
+     * \return whether all arguments were parsed
+     */
+    template <typename It>
+    bool ParseArgs(It begin, It end, It &stop) {
+        if (!Prepare()) {
+            stop = begin;
+            return false;
+        }
+        ParseState state(_error, _stats);
+        state.dispatch = !_commands.empty();
+        if (!Parse(state, begin, end, stop)) {
+            return false;
+        }
+        if (!state.command) {
+            return true;
+        }
+        ArgumentParser &child = Select(*state.command);
+        return child.ParseArgs(std::next(stop), end, stop) ||
+            Inherit(child, state.commandIndex + 1);
+    }
+
+    /** Parse all arguments.
+     *
+     * \param begin an iterator to the beginning of the argument list
+     * \param end an iterator to the past-the-end element of the argument list
+     * \return whether all arguments were parsed
+     */
+    template <typename It>
+    bool ParseArgs(It begin, It end) {
+        It stop = begin;
+        return ParseArgs(begin, end, stop);
+    }
+
+    /** Parse all arguments into a Result rather than into the parser.
+     *
+     * The parser itself is not modified, so any number of threads may do this
+     * at once with the same frozen parser, each with its own Result.
+     *
+     * \param begin an iterator to the beginning of the argument list
+     * \param end an iterator to the past-the-end element of the argument list
+     * \param result a Result of this parser, which is reset first, and
+     * receives the values, matches, and error
+     * \return whether all arguments were parsed; a parser with subcommands
+     * always fails with ErrorCode::Schema, as a Result holds no command's
+     * values
+     */
+    template <typename It>
+    bool ParseArgs(It begin, It end, Result &result) const {
+        if (!Prepare(result)) {
+            return false;
+        }
+        ParseState state(result._error, result._stats, &result);
+        It stop = begin;
+        return Parse(state, begin, end, stop);
+    }
+
+    /** Parse all arguments.
+     *
+     * \param args an iterable of the arguments
+     * \return whether all arguments were parsed
+     */
+    template <typename T>
+    bool ParseArgs(const T &args) {
+        return ParseArgs(std::begin(args), std::end(args));
+    }
+
+    template <typename T>
+    bool ParseArgs(const T &args, Result &result) const {
+        return ParseArgs(std::begin(args), std::end(args), result);
+    }
+
+    /** Parse a whole command string, such as a line typed into a shell.
+     *
+     * The command is split into words with Tokenizer, and each word is
+     * parsed as soon as it is split, so that the words are never gathered
+     * into a list.  Words without quotes or escapes are views of the command,
+     * which must outlive any lazy values parsed from them.
+     */
+    bool ParseCommand(const StringView &command) {
+        Tokenizer words(command);
+        return ParseWords(words);
+    }
+
+    /** Parse a whole command string into a Result
+     */
+    bool ParseCommand(const StringView &command, Result &result) const {
+        if (!Prepare(result)) {
+            return false;
+        }
+        ParseState state(result._error, result._stats, &result);
+        Tokenizer words(command);
+        return ParseCommand(state, words);
+    }
+
+    /** Convenience function to parse the CLI from argc and argv
+     *
+     * Just assigns the program name and parses the arguments in place with
+     * ParseArgs(), viewing each argv entry directly rather than copying it
+     * into a List first.
+     *
+     * \return whether or not all arguments were parsed, including those of
+     * any subcommand
+     */
+    bool ParseCLI(const int argc, const char *const *argv) {
+        if (_prog.empty()) {
+            _prog = String(argv[0]);
+            _help_rendered = false;
+        }
+        return ParseArgs(argv + 1, argv + argc);
+    }
+
+    /** Parse the CLI from argc and argv into a Result.
+     *
+     * Unlike ParseCLI(argc, argv), this leaves the program name alone, so
+     * that it doesn't modify the parser.
+     */
+    bool ParseCLI(
+        const int argc, const char *const *argv, Result &result) const {
+        return ParseArgs(argv + 1, argv + argc, result);
+    }
+
+    /** The values and matches of a single parse, kept apart from the parser.
+     *
+     * A Result lays out a slot for the value of every option and positional
+     * of a parser in one buffer, each constructed from its default.  Build it
+     * once the parser's schema is complete.  It is reset at the start of each
+     * parse into it, so it can be reused, and keeps the storage its values
+     * have allocated.
+     */
+    class Result {
+        private:
+        friend class ArgumentParser;
+
+        struct Slot {
+            const ValueRoot *value;
+            std::size_t offset;
+        };
+
+        List<Slot> _slots;
+        List<std::max_align_t> _buffer;
+        std::size_t _base;
+        List<bool> _matched;
+        ParseError _error;
+        Stats *_stats;
+
+        Result(const Result &) = delete;
+        Result &operator=(const Result &) = delete;
+
+        void Place(const Node &node, std::size_t &size,
+            std::size_t &alignment) {
+            const std::size_t align = node.value->SlotAlignment();
+            size = (size + align - 1) / align * align;
+            _slots[node.slot] = Slot{node.value, size};
+            size += node.value->SlotSize();
+            alignment = std::max(alignment, align);
+        }
+
+        // The buffer's elements are only aligned for max_align_t, so it is
+        // allocated with room to align its start for over-aligned values
+        void Allocate(const std::size_t size, const std::size_t alignment) {
+            _buffer.resize((size + alignment - alignof(std::max_align_t) +
+                               sizeof(std::max_align_t) - 1) /
+                sizeof(std::max_align_t));
+            const std::size_t misalignment =
+                reinterpret_cast<std::uintptr_t>(_buffer.data()) % alignment;
+            _base = misalignment ? alignment - misalignment : 0;
+        }
+
+        void *Get(const std::size_t slot) {
+            return reinterpret_cast<unsigned char *>(_buffer.data()) + _base +
+                _slots[slot].offset;
+        }
+
+        const void *Get(const std::size_t slot) const {
+            return reinterpret_cast<const unsigned char *>(_buffer.data()) +
+                _base + _slots[slot].offset;
+        }
+
+        public:
+        explicit Result(const ArgumentParser &parser)
+            : _slots(parser.Slots()),
+              _base(0),
+              _matched(parser.Slots(), false),
+              _stats(nullptr) {
+            if (_slots.empty()) {
+                return;
+            }
+            std::size_t size = 0;
+            std::size_t alignment = alignof(std::max_align_t);
+            for (const Node &node : parser._options) {
+                Place(node, size, alignment);
+            }
+            for (const Node &node : parser._positionals) {
+                Place(node, size, alignment);
+            }
+            Allocate(size, alignment);
+            for (std::size_t i = 0; i < _slots.size(); ++i) {
+                _slots[i].value->ConstructSlot(Get(i));
+            }
+        }
+
+        Result(Result &&other) = default;
+
+        ~Result() {
+            for (std::size_t i = 0; i < _slots.size(); ++i) {
+                _slots[i].value->DestroySlot(Get(i));
+            }
+        }
+
+        template <typename T>
+        const T &Value(const Option<T> &option) const {
+            return *static_cast<const T *>(Get(option.Slot()));
+        }
+
+        template <typename T>
+        const T &Value(const Positional<T> &positional) const {
+            return *static_cast<const T *>(Get(positional.Slot()));
+        }
+
+        /** Move a value out of the Result, leaving it moved-from until the
+         * next parse into the Result resets it
+         */
+        template <typename T>
+        T TakeValue(const Option<T> &option) {
+            return std::move(*static_cast<T *>(Get(option.Slot())));
+        }
+
+        template <typename T>
+        T TakeValue(const Positional<T> &positional) {
+            return std::move(*static_cast<T *>(Get(positional.Slot())));
+        }
+
+        bool Matched(const Root &node) const { return _matched[node.Slot()]; }
+
+        const String &Error() const { return _error.Message(); }
+
+        const ParseError &LastError() const { return _error; }
+
+        /** Count every parse into this Result in the given Stats, or in none
+         * if it is null
+         */
+        Result &Instrument(Stats *stats) {
+            _stats = stats;
+            return *this;
+        }
+
+        Stats *Instrumentation() const { return _stats; }
+
+        /** Restore every value to its default, mark everything unmatched, and
+         * clear the error
+         */
+        void Reset() {
+            for (std::size_t i = 0; i < _slots.size(); ++i) {
+                _slots[i].value->ResetSlot(Get(i));
+                _matched[i] = false;
+            }
+            _error.Clear();
+        }
+    };
+
+    /** The arguments of one record in a buffer, each ended by a delimiter.
+     *
+     * The last argument may leave out its delimiter, so "a\0b\0" and "a\0b"
+     * are both the arguments "a" and "b", while "a\0\0" is "a" and "".
+     */
+    class Record {
+        private:
+        StringView _text;
+        Char _delimiter;
+
+        public:
+        class Iterator {
+            private:
+            const Char *_pos;
+            const Char *_next;
+            const Char *_end;
+            Char _delimiter;
+
+            public:
+            Iterator(const Char *pos, const Char *end, const Char delimiter)
+                : _pos(pos),
+                  _next(std::find(pos, end, delimiter)),
+                  _end(end),
+                  _delimiter(delimiter) {}
+
+            StringView operator*() const {
+                return StringView(_pos, _next - _pos);
+            }
+
+            Iterator &operator++() {
+                _pos = _next == _end ? _end : _next + 1;
+                _next = std::find(_pos, _end, _delimiter);
+                return *this;
+            }
+
+            bool operator==(const Iterator &other) const {
+                return _pos == other._pos;
+            }
+
+            bool operator!=(const Iterator &other) const {
+                return _pos != other._pos;
+            }
+        };
+
+        Record(const StringView &text, const Char delimiter)
+            : _text(text), _delimiter(delimiter) {}
+
+        Iterator begin() const {
+            return Iterator(_text.begin(), _text.end(), _delimiter);
+        }
+
+        Iterator end() const {
+            return Iterator(_text.end(), _text.end(), _delimiter);
+        }
+    };
+
+    /** The values and matches of many parses, stored by column.
+     *
+     * A Batch holds a List of the values of every option and positional of a
+     * parser, with one row per record, and a bitset of the records that each
+     * was matched in.  A record that fails to parse still gets a row, holding
+     * whatever was parsed before the failure, and its error is listed in
+     * Failures() in record order.  Build it once the parser's schema is
+     * complete; it keeps the storage of its columns between batches.
      */
-    bool ParseCLI(const int argc, const char *const *argv) {
-        if (_prog.empty()) {
-            _prog = String(argv[0]);
+    class Batch {
+        public:
+        struct Failure {
+            std::size_t record;
+            String error;
+        };
+
+        private:
+        friend class ArgumentParser;
+
+        struct Column {
+            const ValueRoot *value;
+            std::size_t offset;
+        };
+
+        List<Column> _columns;
+        List<std::max_align_t> _buffer;
+        std::size_t _base;
+        // The bits of the records a node is matched in start at its slot
+        // times _words
+        List<std::uint64_t> _matched;
+        std::size_t _words;
+        std::size_t _size;
+        List<Failure> _failures;
+        String _error;
+
+        Batch(const Batch &) = delete;
+        Batch &operator=(const Batch &) = delete;
+
+        void Place(const Node &node, std::size_t &size,
+            std::size_t &alignment) {
+            const std::size_t align = node.value->ColumnAlignment();
+            size = (size + align - 1) / align * align;
+            _columns[node.slot] = Column{node.value, size};
+            size += node.value->ColumnSize();
+            alignment = std::max(alignment, align);
+        }
+
+        // The buffer's elements are only aligned for max_align_t, so it is
+        // allocated with room to align its start for over-aligned values
+        void Allocate(const std::size_t size, const std::size_t alignment) {
+            _buffer.resize((size + alignment - alignof(std::max_align_t) +
+                               sizeof(std::max_align_t) - 1) /
+                sizeof(std::max_align_t));
+            const std::size_t misalignment =
+                reinterpret_cast<std::uintptr_t>(_buffer.data()) % alignment;
+            _base = misalignment ? alignment - misalignment : 0;
+        }
+
+        void *Get(const std::size_t slot) {
+            return reinterpret_cast<unsigned char *>(_buffer.data()) + _base +
+                _columns[slot].offset;
+        }
+
+        const void *Get(const std::size_t slot) const {
+            return reinterpret_cast<const unsigned char *>(_buffer.data()) +
+                _base + _columns[slot].offset;
+        }
+
+        void Resize(const std::size_t size) {
+            for (std::size_t i = 0; i < _columns.size(); ++i) {
+                _columns[i].value->ResizeColumn(Get(i), size);
+            }
+            _words = (size + 63) / 64;
+            _matched.assign(_columns.size() * _words, 0);
+            _size = size;
+            _failures.clear();
+            _error.clear();
+        }
+
+        // Threads store into disjoint blocks of whole words of rows
+        void Store(const std::size_t row, Result &result) {
+            for (std::size_t i = 0; i < _columns.size(); ++i) {
+                _columns[i].value->StoreColumn(Get(i), row, result.Get(i));
+                if (result._matched[i]) {
+                    _matched[i * _words + row / 64] |=
+                        std::uint64_t(1) << (row % 64);
+                }
+            }
+        }
+
+        public:
+        explicit Batch(const ArgumentParser &parser)
+            : _columns(parser.Slots()), _base(0), _words(0), _size(0) {
+            if (_columns.empty()) {
+                return;
+            }
+            std::size_t size = 0;
+            std::size_t alignment = alignof(std::max_align_t);
+            for (const Node &node : parser._options) {
+                Place(node, size, alignment);
+            }
+            for (const Node &node : parser._positionals) {
+                Place(node, size, alignment);
+            }
+            Allocate(size, alignment);
+            for (std::size_t i = 0; i < _columns.size(); ++i) {
+                _columns[i].value->ConstructColumn(Get(i));
+            }
+        }
+
+        Batch(Batch &&other) = default;
+
+        ~Batch() {
+            for (std::size_t i = 0; i < _columns.size(); ++i) {
+                _columns[i].value->DestroyColumn(Get(i));
+            }
+        }
+
+        /** The number of records in the last batch
+         */
+        std::size_t Size() const { return _size; }
+
+        template <typename T>
+        const List<T> &Values(const Option<T> &option) const {
+            return *static_cast<const List<T> *>(Get(option.Slot()));
+        }
+
+        template <typename T>
+        const List<T> &Values(const Positional<T> &positional) const {
+            return *static_cast<const List<T> *>(Get(positional.Slot()));
+        }
+
+        bool Matched(const Root &node, const std::size_t record) const {
+            return (_matched[node.Slot() * _words + record / 64] >>
+                       (record % 64)) &
+                1;
+        }
+
+        const List<Failure> &Failures() const { return _failures; }
+
+        /** An error that stopped the whole batch, such as an unreadable file
+         */
+        const String &Error() const { return _error; }
+    };
+
+    private:
+    template <typename It>
+    void ParseBlock(It it, const std::size_t first, const std::size_t count,
+        Batch &batch, List<typename Batch::Failure> &failures) const {
+        // One Result for the whole block, so that its setup is only paid once
+        Result result(*this);
+        for (std::size_t row = first; row < first + count; ++row, ++it) {
+            if (!ParseArgs(std::begin(*it), std::end(*it), result)) {
+                failures.push_back({row, result._error.Message()});
+            }
+            batch.Store(row, result);
+        }
+    }
+
+    public:
+    /** Parse many argument vectors into a Batch, one record for each.
+     *
+     * Like parsing into a Result, this leaves the parser alone.  With more
+     * than one thread, the records are split into contiguous blocks that are
+     * parsed at once, each into its own rows of the same columns.
+     *
+     * \param begin an iterator to the first argument vector, each of which is
+     * an iterable of arguments
+     * \param end an iterator to the past-the-end argument vector
+     * \param batch a Batch of this parser, which is resized to the number of
+     * records and receives their values, matches, and errors
+     * \param threads the most threads to parse with
+     * \return whether every record was parsed; never, for a parser with
+     * subcommands
+     */
+    template <typename It>
+    bool ParseBatch(
+        It begin, It end, Batch &batch, const unsigned threads = 1) const {
+        const std::size_t size = std::distance(begin, end);
+        batch.Resize(size);
+        if (!_schema_error.empty()) {
+            batch._error = _schema_error;
+            return false;
+        }
+        if (Unconverted(batch._error)) {
+            return false;
+        }
+        if (!_commands.empty()) {
+            batch._error.assign(
+                "subcommands are not supported when parsing into a Batch");
+            return false;
+        }
+        if (batch._columns.size() != _storage.size()) {
+            batch._error.assign(
+                "Batch does not match the options of this parser");
+            return false;
+        }
+
+        // Split into whole words of the matched bitsets, so that no two
+        // threads ever write the same word
+        const std::size_t count = threads > 1 ? threads : 1;
+        const std::size_t block = (batch._words + count - 1) / count * 64;
+        if (count == 1 || size <= block) {
+            ParseBlock(begin, 0, size, batch, batch._failures);
+        } else {
+            List<List<typename Batch::Failure>> failures(
+                (size + block - 1) / block);
+            List<std::thread> workers;
+            for (std::size_t first = 0, i = 0; first < size;
+                 first += block, ++i) {
+                const std::size_t rows = std::min(block, size - first);
+                workers.emplace_back([this, begin, first, rows, &batch,
+                                         &failures, i] {
+                    ParseBlock(begin, first, rows, batch, failures[i]);
+                });
+                std::advance(begin, rows);
+            }
+            for (std::thread &worker : workers) {
+                worker.join();
+            }
+            for (List<typename Batch::Failure> &block : failures) {
+                for (typename Batch::Failure &failure : block) {
+                    batch._failures.push_back(std::move(failure));
+                }
+            }
+        }
+        return batch._failures.empty();
+    }
+
+    template <typename T>
+    bool ParseBatch(
+        const T &vectors, Batch &batch, const unsigned threads = 1) const {
+        return ParseBatch(
+            std::begin(vectors), std::end(vectors), batch, threads);
+    }
+
+    /** Parse a buffer of delimited records into a Batch.
+     *
+     * Records are ended by recordDelimiter, and the arguments within them by
+     * argumentDelimiter, as described for Record.  The default delimiters
+     * read a log of NUL-separated argument vectors, one to a line, like
+     * /proc/PID/cmdline with newlines between them.
+     *
+     * The buffer must outlive the parse; string values are copied out of it.
+     */
+    bool ParseRecords(const StringView &buffer, Batch &batch,
+        const unsigned threads = 1, const Char argumentDelimiter = Char(),
+        const Char recordDelimiter = Char('\n')) const {
+        List<Record> records;
+        Reserve(records,
+            std::count(buffer.begin(), buffer.end(), recordDelimiter) + 1, 0);
+        const Char *pos = buffer.begin();
+        while (pos != buffer.end()) {
+            const Char *next = std::find(pos, buffer.end(), recordDelimiter);
+            records.emplace_back(
+                StringView(pos, next - pos), argumentDelimiter);
+            pos = next == buffer.end() ? next : next + 1;
+        }
+        return ParseBatch(records.begin(), records.end(), batch, threads);
+    }
+
+    /** Map a whole file and parse its delimited records into a Batch, as
+     * ParseRecords() does
+     */
+    bool ParseRecordFile(const char *path, Batch &batch,
+        const unsigned threads = 1, const Char argumentDelimiter = Char(),
+        const Char recordDelimiter = Char('\n')) const {
+        const MappedFile file(path);
+        if (!file.Valid()) {
+            batch.Resize(0);
+            batch._error.assign("Could not read file: ");
+            batch._error.append(path);
+            return false;
+        }
+        return ParseRecords(
+            file.View(), batch, threads, argumentDelimiter, recordDelimiter);
+    }
+
+    /** The error of the last parse, as text
+     */
+    const String &Error() const { return _error.Message(); }
+
+    /** Replace the error with a message of your own, which is reported with
+     * ErrorCode::Custom
+     */
+    ArgumentParser &Error(const String &error) {
+        _error.Assign(ErrorCode::Custom, error);
+        return *this;
+    }
+
+    /** The error of the last parse, in pieces
+     */
+    const ParseError &LastError() const { return _error; }
+
+    /** A single short or long flag of a FixedMatcher.
+     *
+     * This is the literal counterpart of EitherFlag: Chars are short flags and
+     * strings are long flags.
+     */
+    struct FixedFlag {
+        const bool isShort;
+        const Char shortFlag;
+        const Char *const longFlag;
+        constexpr FixedFlag(const Char flag)
+            : isShort(true), shortFlag(flag), longFlag(nullptr) {}
+        constexpr FixedFlag(const Char *flag)
+            : isShort(false), shortFlag(), longFlag(flag) {}
+    };
+
+    /** The literal counterpart of Matcher, with up to one short and one long
+     * flag, given in either order:
+     *
+     *     FixedMatcher{'h', "help"}
+     *     FixedMatcher{"foo"}
+     *
+     * A FixedMatcher without flags makes its option a positional.  Two flags
+     * of the same kind, like {'a', 'b'}, don't compile in a constexpr
+     * specification, and make FixedUnique false in any other.
+     */
+    struct FixedMatcher {
+        const bool hasShort;
+        const Char shortFlag;
+        const Char *const longFlag;
+        const bool valid;
+
+        constexpr FixedMatcher()
+            : hasShort(false), shortFlag(), longFlag(nullptr), valid(true) {}
+        constexpr FixedMatcher(const FixedFlag flag)
+            : hasShort(flag.isShort),
+              shortFlag(flag.shortFlag),
+              longFlag(flag.longFlag),
+              valid(true) {}
+        constexpr FixedMatcher(const FixedFlag first, const FixedFlag second)
+            : hasShort(first.isShort || second.isShort),
+              shortFlag(first.isShort ? first.shortFlag : second.shortFlag),
+              longFlag(first.isShort ? second.longFlag : first.longFlag),
+              valid(first.isShort != second.isShort ||
+                  NeedsOneShortAndOneLongFlag()) {}
+
+        constexpr bool Positional() const {
+            return !hasShort && longFlag == nullptr;
+        }
+
+        private:
+        // Not constexpr, so that calling it fails constant evaluation
+        static bool NeedsOneShortAndOneLongFlag() { return false; }
+    };
+
+    /** One named slot of a FixedParser specification
+     */
+    struct FixedOption {
+        const Char *const name;
+        const FixedMatcher matcher;
+        constexpr FixedOption(
+            const Char *name, const FixedMatcher matcher = FixedMatcher())
+            : name(name), matcher(matcher) {}
+    };
+
+    private:
+    static constexpr bool FixedSame(const Char *lhs, const Char *rhs) {
+        return *lhs == *rhs && (*lhs == Char() || FixedSame(lhs + 1, rhs + 1));
+    }
+
+    static constexpr bool FixedConflict(
+        const FixedMatcher &lhs, const FixedMatcher &rhs) {
+        return (lhs.hasShort && rhs.hasShort &&
+                   lhs.shortFlag == rhs.shortFlag) ||
+            (lhs.longFlag && rhs.longFlag &&
+                FixedSame(lhs.longFlag, rhs.longFlag));
+    }
+
+    // Whether spec[i] shares no flag with any of spec[j..n); recursing over
+    // one index at a time keeps the constexpr depth linear in n
+    static constexpr bool FixedApart(const FixedOption *spec,
+        const std::size_t n, const std::size_t i, const std::size_t j) {
+        return j >= n ||
+            (!FixedConflict(spec[i].matcher, spec[j].matcher) &&
+                FixedApart(spec, n, i, j + 1));
+    }
+
+    static constexpr bool FixedUnique(
+        const FixedOption *spec, const std::size_t n, const std::size_t i) {
+        return i >= n ||
+            (spec[i].matcher.valid && FixedApart(spec, n, i, i + 1) &&
+                FixedUnique(spec, n, i + 1));
+    }
+
+    /* The short or the long flags of a specification, as the keys of a
+     * perfect hash.  A seed is searched for at compile time, first among the
+     * smallest tables of at least twice as many buckets as slots, doubling
+     * them until no two keys fall into one bucket; duplicate flags never
+     * spread, so their search fails with npos.
+     */
+    struct FixedKeys {
+        static const std::size_t npos = static_cast<std::size_t>(-1);
+        static const std::size_t Tries = 16;
+        static const unsigned MaxBits = 16;
+        static const std::uint64_t Basis = 0xcbf29ce484222325ULL;
+
+        const FixedOption *const spec;
+        const std::size_t size;
+        const bool isLong;
+
+        constexpr FixedKeys(const FixedOption *spec, const std::size_t size,
+            const bool isLong)
+            : spec(spec), size(size), isLong(isLong) {}
+
+        static constexpr std::uint64_t Seed(const std::size_t k) {
+            return 0x100000001b3ULL + k * 0x9e3779b97f4a7c16ULL;
+        }
+
+        static constexpr std::uint64_t Mix(
+            const std::uint64_t hash, const Char c, const std::uint64_t seed) {
+            return (hash ^
+                       static_cast<typename std::make_unsigned<Char>::type>(
+                           c)) *
+                seed;
+        }
+
+        static constexpr std::uint64_t HashText(const Char *text,
+            const std::uint64_t seed, const std::uint64_t hash) {
+            return *text == Char()
+                ? hash
+                : HashText(text + 1, seed, Mix(hash, *text, seed));
+        }
+
+        static constexpr std::size_t Bucket(
+            const std::uint64_t hash, const unsigned bits) {
+            return static_cast<std::size_t>(
+                (hash ^ (hash >> 32)) & ((std::uint64_t(1) << bits) - 1));
+        }
+
+        constexpr bool Has(const std::size_t i) const {
+            return isLong ? spec[i].matcher.longFlag != nullptr
+                          : spec[i].matcher.hasShort;
+        }
+
+        constexpr std::size_t BucketOf(const std::size_t i,
+            const std::uint64_t seed, const unsigned bits) const {
+            return Bucket(isLong
+                    ? HashText(spec[i].matcher.longFlag, seed, Basis)
+                    : Mix(Basis, spec[i].matcher.shortFlag, seed),
+                bits);
+        }
+
+        constexpr bool Spread(const std::uint64_t seed, const unsigned bits,
+            const std::size_t i, const std::size_t j) const {
+            return j >= size ||
+                ((!Has(j) ||
+                     BucketOf(i, seed, bits) != BucketOf(j, seed, bits)) &&
+                    Spread(seed, bits, i, j + 1));
+        }
+
+        constexpr bool Perfect(const std::uint64_t seed, const unsigned bits,
+            const std::size_t i) const {
+            return i >= size ||
+                ((!Has(i) || Spread(seed, bits, i, i + 1)) &&
+                    Perfect(seed, bits, i + 1));
+        }
+
+        constexpr unsigned MinBits(const unsigned bits) const {
+            return (std::size_t(1) << bits) >= 2 * size
+                ? bits
+                : MinBits(bits + 1);
+        }
+
+        constexpr std::size_t Search(const unsigned bits) const {
+            return Search(bits, 0);
+        }
+
+        constexpr std::size_t Search(
+            const unsigned bits, const std::size_t k) const {
+            return Perfect(Seed(k), bits, 0) ? bits * Tries + k
+                : k + 1 < Tries              ? Search(bits, k + 1)
+                : bits < MaxBits &&
+                    (std::size_t(1) << bits) < 4 * size * size
+                ? Search(bits + 1, 0)
+                : npos;
+        }
+
+        // The slot whose key falls into bucket, or size for none
+        constexpr std::size_t Owner(const std::uint64_t seed,
+            const unsigned bits, const std::size_t bucket,
+            const std::size_t i) const {
+            return i >= size ? size
+                : Has(i) && BucketOf(i, seed, bits) == bucket
+                ? i
+                : Owner(seed, bits, bucket, i + 1);
         }
-        const List<String> args(argv + 1, argv + argc);
-        return ParseArgs(args);
+    };
+
+    template <std::size_t... I>
+    struct FixedIndices {
+        using Doubled = FixedIndices<I..., (sizeof...(I) + I)...>;
+    };
+
+    // The 2^Bits indices of a table; the dummy allows the partial
+    // specialization in class scope
+    template <unsigned Bits, typename Dummy = void>
+    struct FixedBuckets {
+        using Type = typename FixedBuckets<Bits - 1>::Type::Doubled;
+    };
+
+    template <typename Dummy>
+    struct FixedBuckets<0, Dummy> {
+        using Type = FixedIndices<0>;
+    };
+
+    public:
+    /** Check at compile time that no flag is used twice in a specification,
+     * and that no matcher has two flags of the same kind:
+     *
+     *     static_assert(Parser::FixedUnique(spec), "duplicate flags");
+     *
+     * A FixedParser checks this too, and refuses to parse a specification
+     * that fails it.
+     */
+    template <std::size_t N>
+    static constexpr bool FixedUnique(const FixedOption (&spec)[N]) {
+        return FixedUnique(spec, N, 0);
     }
 
-    const String &Error() const { return _error; }
+    /** A parser whose whole specification is fixed at compile time.
+     *
+     * The options are a constexpr table of FixedOption, one per value type,
+     * given as a template argument so that its flags are constants:
+     *
+     *     using Parser = argsplus::ArgumentParser<>;
+     *     constexpr Parser::FixedOption spec[] = {
+     *         {"DOUBLE", {'d', "double"}}, {"COUNT", {'c'}}, {"FILE"}};
+     *     Parser::FixedParser<spec, double, int, std::string> parser;
+     *
+     * Short and long flags are each looked up through a perfect hash whose
+     * seed and table are computed by the compiler, so a flag costs one hash
+     * and one comparison, and constructing the parser costs nothing beyond
+     * initializing its values.  A specification with duplicate flags still
+     * compiles, but ParseArgs fails on it with the same error ArgumentParser
+     * gives.
+     *
+     * Values are statically typed slots, accessed with Value<I>() and given
+     * defaults with Default<I>(), and are converted without virtual dispatch.
+     * The syntax is always the ArgumentParser default: "--" long prefix, "-"
+     * short prefix, "=" long separator, "--" option terminator, and both
+     * joined and separate values.
+     */
+    template <const FixedOption *Spec, typename... Types>
+    class FixedParser {
+        private:
+        static const std::size_t Size = sizeof...(Types);
+        static const std::size_t npos = static_cast<std::size_t>(-1);
+
+        static constexpr std::size_t LongHash =
+            FixedKeys(Spec, Size, true)
+                .Search(FixedKeys(Spec, Size, true).MinBits(1));
+        static constexpr std::size_t ShortHash =
+            FixedKeys(Spec, Size, false)
+                .Search(FixedKeys(Spec, Size, false).MinBits(1));
+        static constexpr std::uint64_t LongSeed =
+            FixedKeys::Seed(LongHash == npos ? 0 : LongHash % FixedKeys::Tries);
+        static constexpr std::uint64_t ShortSeed = FixedKeys::Seed(
+            ShortHash == npos ? 0 : ShortHash % FixedKeys::Tries);
+        static constexpr unsigned LongBits = LongHash == npos
+            ? 1
+            : static_cast<unsigned>(LongHash / FixedKeys::Tries);
+        static constexpr unsigned ShortBits = ShortHash == npos
+            ? 1
+            : static_cast<unsigned>(ShortHash / FixedKeys::Tries);
+        static constexpr bool Valid = FixedUnique(Spec, Size, 0) &&
+            LongHash != npos && ShortHash != npos;
+
+        using Slot = typename std::conditional<
+            (Size < std::numeric_limits<unsigned char>::max()), unsigned char,
+            std::size_t>::type;
+
+        std::tuple<Types...> _defaults;
+        std::tuple<Types...> _values;
+        std::array<bool, Size> _matched;
+        String _error;
+
+        // The table is a constant, so that neither construction nor the
+        // first lookup initializes anything
+        template <bool IsLong, std::size_t... Buckets>
+        static const Slot *Table(FixedIndices<Buckets...>) {
+            static constexpr Slot table[] = {
+                static_cast<Slot>(FixedKeys(Spec, Size, IsLong)
+                                      .Owner(IsLong ? LongSeed : ShortSeed,
+                                          IsLong ? LongBits : ShortBits,
+                                          Buckets, 0))...};
+            return table;
+        }
+
+        static std::size_t FindShort(const Char flag) {
+            const std::size_t slot =
+                Table<false>(typename FixedBuckets<ShortBits>::Type())
+                    [FixedKeys::Bucket(
+                        FixedKeys::Mix(FixedKeys::Basis, flag, ShortSeed),
+                        ShortBits)];
+            return slot < Size && Spec[slot].matcher.shortFlag == flag
+                ? slot
+                : npos;
+        }
+
+        static std::size_t FindLong(const StringView &flag) {
+            std::uint64_t hash = FixedKeys::Basis;
+            for (std::size_t i = 0; i < flag.size(); ++i) {
+                hash = FixedKeys::Mix(hash, flag[i], LongSeed);
+            }
+            const std::size_t slot = Table<true>(
+                typename FixedBuckets<LongBits>::Type())[FixedKeys::Bucket(
+                hash, LongBits)];
+            if (slot >= Size) {
+                return npos;
+            }
+            const Char *longFlag = Spec[slot].matcher.longFlag;
+            std::size_t pos = 0;
+            while (pos < flag.size() && longFlag[pos] == flag[pos]) {
+                ++pos;
+            }
+            return pos == flag.size() && longFlag[pos] == Char() ? slot : npos;
+        }
+
+        // Only reached for an invalid specification, so it may take its time
+        bool SpecError() {
+            for (std::size_t i = 0; i < Size; ++i) {
+                const FixedMatcher &matcher = Spec[i].matcher;
+                if (!matcher.valid) {
+                    _error.assign("Option '");
+                    _error.append(Spec[i].name);
+                    _error.append("' has two flags of the same kind");
+                    return false;
+                }
+                for (std::size_t j = i + 1; j < Size; ++j) {
+                    const FixedMatcher &other = Spec[j].matcher;
+                    if (!FixedConflict(matcher, other)) {
+                        continue;
+                    }
+                    _error.assign("Flag '");
+                    if (matcher.hasShort && other.hasShort &&
+                        matcher.shortFlag == other.shortFlag) {
+                        _error.append(1, matcher.shortFlag);
+                    } else {
+                        _error.append(matcher.longFlag);
+                    }
+                    _error.append("' was registered to more than one option");
+                    return false;
+                }
+            }
+            _error.assign("The flags could not be hashed");
+            return false;
+        }
+
+        static bool IsListSlot(const std::size_t slot) {
+            const bool lists[] = {IsList<Types>::value..., false};
+            return lists[slot];
+        }
+
+        // Unrolled into a switch over the slots by the compiler
+        template <std::size_t I>
+        typename std::enable_if<(I < Size), bool>::type ParseSlot(
+            const std::size_t slot, const StringView &value) {
+            return slot == I ? ExtractValue(value, std::get<I>(_values))
+                             : ParseSlot<I + 1>(slot, value);
+        }
+
+        template <std::size_t I>
+        typename std::enable_if<(I == Size), bool>::type ParseSlot(
+            const std::size_t, const StringView &) {
+            return false;
+        }
+
+        bool FlagError(const StringView &flag, const char *message) {
+            _error.assign("Flag '");
+            _error.append(flag.data(), flag.size());
+            _error.append(message);
+            return false;
+        }
+
+        bool FlagValue(const std::size_t slot, const StringView &flag,
+            const StringView &value) {
+            _matched[slot] = true;
+            return ParseSlot<0>(slot, value) ||
+                FlagError(flag, "' received an invalid value");
+        }
+
+        public:
+        FixedParser() : _defaults(), _values(), _matched() {}
+
+        template <std::size_t I>
+        const typename std::tuple_element<I, std::tuple<Types...>>::type &
+        Default() const {
+            return std::get<I>(_defaults);
+        }
+
+        /** Set the value slot I takes when a parse doesn't match it, which is
+         * also its value until the next parse
+         */
+        template <std::size_t I>
+        FixedParser &Default(
+            const typename std::tuple_element<I, std::tuple<Types...>>::type
+                &value) {
+            std::get<I>(_defaults) = value;
+            std::get<I>(_values) = value;
+            return *this;
+        }
+
+        template <std::size_t I>
+        const typename std::tuple_element<I, std::tuple<Types...>>::type &
+        Value() const {
+            return std::get<I>(_values);
+        }
+
+        template <std::size_t I>
+        typename std::tuple_element<I, std::tuple<Types...>>::type &Value() {
+            return std::get<I>(_values);
+        }
+
+        bool Matched(const std::size_t slot) const { return _matched[slot]; }
+
+        const String &Error() const { return _error; }
+
+        /** Parse all arguments, like ArgumentParser::ParseArgs
+         *
+         * Every value is reset to its default, and every match and the error
+         * are cleared first, so that each parse starts from a freshly
+         * constructed FixedParser.  A specification that FixedUnique rejects
+         * fails every parse.
+         */
+        template <typename It>
+        bool ParseArgs(It begin, It end) {
+            _values = _defaults;
+            _matched.fill(false);
+            _error.clear();
+            if (!Valid) {
+                return SpecError();
+            }
+            const Char terminator[] = {Char('-'), Char('-')};
+            const StringView doubleDash(terminator, 2);
+            bool terminated = false;
+            std::size_t positional = 0;
+            for (auto it = begin; it != end; ++it) {
+                const StringView chunk(*it);
+                if (!terminated && chunk == doubleDash) {
+                    terminated = true;
+                } else if (!terminated && chunk.size() > 2 &&
+                    chunk.StartsWith(doubleDash)) {
+                    const StringView argchunk = chunk.substr(2);
+                    const std::size_t separator =
+                        std::find(argchunk.begin(), argchunk.end(),
+                            Char('=')) -
+                        argchunk.begin();
+                    const StringView arg = argchunk.substr(0, separator);
+                    const std::size_t slot = FindLong(arg);
+                    if (slot == npos) {
+                        _error.assign("Flag could not be matched: ");
+                        _error.append(arg.data(), arg.size());
+                        return false;
+                    }
+                    if (separator < argchunk.size()) {
+                        if (!FlagValue(
+                                slot, arg, argchunk.substr(separator + 1))) {
+                            return false;
+                        }
+                    } else if (++it == end) {
+                        return FlagError(
+                            arg, "' requires an argument but received none");
+                    } else if (!FlagValue(slot, arg, StringView(*it))) {
+                        return false;
+                    }
+                } else if (!terminated && chunk.size() > 1 &&
+                    chunk[0] == Char('-')) {
+                    const std::size_t slot = FindShort(chunk[1]);
+                    if (slot == npos) {
+                        _error.assign("Flag could not be matched: ");
+                        _error.append(1, chunk[1]);
+                        return false;
+                    }
+                    const StringView arg = chunk.substr(1, 1);
+                    if (chunk.size() > 2) {
+                        if (!FlagValue(slot, arg, chunk.substr(2))) {
+                            return false;
+                        }
+                    } else if (++it == end) {
+                        return FlagError(
+                            arg, "' requires an argument but received none");
+                    } else if (!FlagValue(slot, arg, StringView(*it))) {
+                        return false;
+                    }
+                } else {
+                    while (positional < Size &&
+                        (!Spec[positional].matcher.Positional() ||
+                            (_matched[positional] &&
+                                !IsListSlot(positional)))) {
+                        ++positional;
+                    }
+                    if (positional == Size) {
+                        _error.assign("Passed in argument, but no positional "
+                                      "arguments were ready to receive it: ");
+                        _error.append(chunk.data(), chunk.size());
+                        return false;
+                    }
+                    if (!ParseSlot<0>(positional, chunk)) {
+                        _error.assign("Positional '");
+                        _error.append(Spec[positional].name);
+                        _error.append("' received an invalid value");
+                        return false;
+                    }
+                    _matched[positional] = true;
+                }
+            }
+            return true;
+        }
+
+        template <typename T>
+        bool ParseArgs(const T &args) {
+            return ParseArgs(std::begin(args), std::end(args));
+        }
 
-    ArgumentParser &Error(const String &error) { _error = error; }
+        bool ParseCLI(const int argc, const char *const *argv) {
+            return ParseArgs(argv + 1, argv + argc);
+        }
+    };
 };
 }
 
@@ -0,0 +1,230 @@
+/* Copyright © 2016 Taylor C. Richberger <taywee@gmx.com>
+ * This code is released under the license described in the LICENSE file
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <argsplus.hxx>
+
+// Count every allocation so that each benchmark can report its cost per parse
+static std::atomic<std::size_t> allocations(0);
+
+void *operator new(std::size_t size) {
+    ++allocations;
+    if (void *ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+// GCC takes the inlined free() below for a mismatch with operator new
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+
+using Parser = argsplus::ArgumentParser<>;
+
+// Keeps the compiler from dropping parses whose results are never read
+static volatile bool sink;
+
+/** Time a parse of the given number of arguments, repeated until enough time
+ * has passed to trust the clock, after one parse to warm up
+ */
+static void Bench(const std::string &name, const std::size_t args,
+    const std::function<bool()> &parse) {
+    using Clock = std::chrono::steady_clock;
+    if (!parse()) {
+        std::cerr << name << ": parse failed" << std::endl;
+        std::exit(1);
+    }
+
+    std::size_t iterations = 0;
+    const std::size_t before = allocations;
+    const Clock::time_point start = Clock::now();
+    Clock::duration elapsed;
+    do {
+        for (int i = 0; i < 16; ++i) {
+            sink = parse();
+        }
+        iterations += 16;
+        elapsed = Clock::now() - start;
+    } while (elapsed < std::chrono::milliseconds(100));
+    const double nanoseconds =
+        std::chrono::duration<double, std::nano>(elapsed).count();
+
+    std::cout << std::left << std::setw(40) << name << std::right
+              << std::setw(8) << args << std::fixed << std::setprecision(1)
+              << std::setw(12) << nanoseconds / iterations / args
+              << std::setprecision(2) << std::setw(14)
+              << static_cast<double>(allocations - before) / iterations
+              << std::endl;
+}
+
+/** Both as Strings for ParseArgs(), and as an argv for ParseCLI()
+ */
+struct Arguments {
+    std::vector<std::string> strings;
+    std::vector<const char *> argv;
+
+    explicit Arguments(std::vector<std::string> args)
+        : strings(std::move(args)) {
+        argv.push_back("bench");
+        for (const std::string &arg : strings) {
+            argv.push_back(arg.c_str());
+        }
+    }
+};
+
+static void BenchParser(const std::string &name, Parser &parser,
+    const Arguments &arguments) {
+    parser.Freeze();
+    Bench(name + " ParseArgs", arguments.strings.size(),
+        [&] { return parser.ParseArgs(arguments.strings); });
+    Bench(name + " ParseCLI", arguments.strings.size(), [&] {
+        return parser.ParseCLI(
+            static_cast<int>(arguments.argv.size()), arguments.argv.data());
+    });
+    Parser::Result result(parser);
+    Bench(name + " Result", arguments.strings.size(),
+        [&] { return parser.ParseArgs(arguments.strings, result); });
+}
+
+// Every option given once, by its long flag, joined or separate
+static void BenchLongFlags(const std::size_t count, const bool joined) {
+    Parser parser;
+    std::vector<std::string> args;
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::string flag = "option-number-" + std::to_string(i);
+        parser.AddOption<int>("OPTION", {flag});
+        if (joined) {
+            args.push_back("--" + flag + "=" + std::to_string(i));
+        } else {
+            args.push_back("--" + flag);
+            args.push_back(std::to_string(i));
+        }
+    }
+    const std::string name = std::to_string(count) + " long";
+    BenchParser(name + (joined ? " joined" : " separate"), parser,
+        Arguments(std::move(args)));
+}
+
+// Short flags, cycling through ten options, joined or separate
+static void BenchShortFlags(const bool joined) {
+    Parser parser;
+    for (char c = 'a'; c < 'k'; ++c) {
+        parser.AddOption<int>("OPTION", {c});
+    }
+    std::vector<std::string> args;
+    for (int i = 0; i < 100; ++i) {
+        const std::string flag{'-', static_cast<char>('a' + i % 10)};
+        if (joined) {
+            args.push_back(flag + std::to_string(i));
+        } else {
+            args.push_back(flag);
+            args.push_back(std::to_string(i));
+        }
+    }
+    BenchParser(joined ? "short joined" : "short separate", parser,
+        Arguments(std::move(args)));
+}
+
+// The same flag many times over, converting numbers or keeping strings
+template <typename T>
+static void BenchValues(const std::string &name) {
+    Parser parser;
+    parser.AddOption<T>("VALUE", {'v', "value"});
+    std::vector<std::string> args;
+    for (int i = 0; i < 100; ++i) {
+        args.push_back("--value=" + std::to_string(1000000 + i));
+    }
+    BenchParser(name, parser, Arguments(std::move(args)));
+}
+
+// Nothing but positionals, into a list
+template <typename T>
+static void BenchPositionals(const std::string &name) {
+    Parser parser;
+    parser.AddPositional<std::vector<T>>("VALUES");
+    std::vector<std::string> args;
+    for (int i = 0; i < 1000; ++i) {
+        args.push_back(std::to_string(1000000 + i));
+    }
+    BenchParser(name, parser, Arguments(std::move(args)));
+}
+
+// One flag whose value is a long delimited list
+template <typename T>
+static void BenchDelimited(const std::string &name) {
+    Parser parser;
+    parser.AddOption<std::vector<T>>("VALUES", {"values"}).Delimiter(',');
+    std::string arg = "--values=";
+    for (int i = 0; i < 1000; ++i) {
+        arg += (i ? "," : "") + std::to_string(1000000 + i);
+    }
+    // Counted per element rather than per argument
+    parser.Freeze();
+    const std::vector<std::string> args{arg};
+    Bench(name, 1000, [&] { return parser.ParseArgs(args); });
+}
+
+// A long lazy list positional, converted by Validate() with some threads
+static void BenchValidate(const unsigned threads) {
+    Parser parser;
+    parser.Lazy(true);
+    parser.AddPositional<std::vector<long long>>("IDS");
+    parser.Freeze();
+    std::vector<std::string> args;
+    for (int i = 0; i < 100000; ++i) {
+        args.push_back(std::to_string(1000000000000LL + i));
+    }
+    Bench("lazy validate " + std::to_string(threads) + " threads",
+        args.size(),
+        [&] { return parser.ParseArgs(args) && parser.Validate(threads); });
+}
+
+// A command string split by the tokenizer rather than by the caller
+static void BenchCommand() {
+    Parser parser;
+    parser.AddOption<int>("NUMBER", {'n', "number"});
+    parser.AddPositional<std::vector<std::string>>("WORDS");
+    parser.Freeze();
+    std::string command;
+    for (int i = 0; i < 100; ++i) {
+        command += "--number=" + std::to_string(i) +
+            " some-rather-long-word 'a-quoted-word' ";
+    }
+    Bench("command ParseCommand", 300,
+        [&] { return parser.ParseCommand(command); });
+}
+
+int main() {
+    std::cout << std::left << std::setw(40) << "benchmark" << std::right
+              << std::setw(8) << "args" << std::setw(12) << "ns/arg"
+              << std::setw(14) << "allocs/parse" << std::endl;
+    for (const std::size_t count : {10, 100, 1000}) {
+        BenchLongFlags(count, true);
+    }
+    BenchLongFlags(100, false);
+    BenchShortFlags(true);
+    BenchShortFlags(false);
+    BenchValues<int>("numeric values");
+    BenchValues<double>("floating values");
+    BenchValues<std::string>("string values");
+    BenchPositionals<int>("numeric positionals");
+    BenchPositionals<std::string>("string positionals");
+    BenchDelimited<int>("delimited numbers");
+    BenchDelimited<std::string>("delimited strings");
+    BenchValidate(1);
+    BenchValidate(4);
+    BenchCommand();
+    return 0;
+}
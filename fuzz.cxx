@@ -0,0 +1,780 @@
+/* Copyright © 2016 Taylor C. Richberger <taywee@gmx.com>
+ * This code is released under the license described in the LICENSE file
+ */
+
+/* A differential fuzzer for the parse paths.
+ *
+ * Each input is a byte of settings followed by arguments separated by NULs.
+ * The arguments are parsed by a naive reference that shares none of the
+ * library's lookups or conversions, and then through every path of the
+ * library: a new, unfrozen, eager parser, a frozen parser that is reused
+ * across inputs, a Result, argv in place, a command string through the
+ * tokenizer, a lazy parser with Validate(), and a parser loaded from a saved
+ * schema.  Each must give exactly the same matches, values, and error as the
+ * reference, or the input aborts.
+ *
+ * Built with -fsanitize=fuzzer (make fuzz), libFuzzer provides main().
+ * Otherwise (make fuzzcheck) main() runs the inputs named on the command
+ * line, or one from stdin for AFL, and can also mutate them or time them.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <argsplus.hxx>
+
+using Parser = argsplus::ArgumentParser<>;
+
+// The handle types are private to the parser, so they are named by what
+// adding a node gives
+template <typename T>
+using Option = typename std::remove_reference<decltype(
+    std::declval<Parser &>().AddOption<T>(
+        std::string(), std::declval<Parser::Matcher>()))>::type;
+template <typename T>
+using Positional = typename std::remove_reference<decltype(
+    std::declval<Parser &>().AddPositional<T>(std::string()))>::type;
+
+/** Every node of the fuzzed schema, in one parser
+ */
+struct Handles {
+    Option<int> *count;
+    Option<std::string> *name;
+    Option<std::vector<std::string>> *include;
+    Option<std::vector<int>> *values;
+    Option<double> *rate;
+    Positional<std::string> *first;
+    Positional<std::vector<long>> *rest;
+};
+
+enum Settings : unsigned char {
+    NoJoinedShort = 1,
+    NoJoinedLong = 2,
+    NoSeparateShort = 4,
+    NoSeparateLong = 8,
+    Abbreviate = 16,
+    // "++" long flags, "+" short flags, and "+" as the terminator, which no
+    // longer take the parser's fast path for the default syntax
+    CustomSyntax = 32,
+    AllSettings = 64,
+};
+
+static Handles Build(Parser &parser, const unsigned settings) {
+    parser.JoinedShort(!(settings & NoJoinedShort))
+        .JoinedLong(!(settings & NoJoinedLong))
+        .SeparateShort(!(settings & NoSeparateShort))
+        .SeparateLong(!(settings & NoSeparateLong))
+        .Abbreviations((settings & Abbreviate) != 0);
+    if (settings & CustomSyntax) {
+        parser.LongPrefix("++").ShortPrefix("+").OptionTerminator("+");
+    }
+    Handles handles;
+    handles.count = &parser.AddOption<int>("COUNT", {'c', "count"});
+    // Two flags with a common prefix, so that abbreviations may be ambiguous
+    handles.name = &parser.AddOption<std::string>("NAME", {'n', "name"});
+    handles.include = &parser.AddOption<std::vector<std::string>>(
+        "INCLUDE", {'I', "include", "includes"});
+    handles.values = &parser.AddOption<std::vector<int>>(
+        "VALUES", {'v', "values"});
+    handles.values->Delimiter(',');
+    handles.rate = &parser.AddOption<double>("RATE", {"rate", "number"});
+    handles.first = &parser.AddPositional<std::string>("FIRST");
+    handles.rest = &parser.AddPositional<std::vector<long>>("REST");
+    return handles;
+}
+
+static Handles Bind(Parser &parser) {
+    Handles handles;
+    handles.count = parser.BindOption<int>("COUNT");
+    handles.name = parser.BindOption<std::string>("NAME");
+    handles.include = parser.BindOption<std::vector<std::string>>("INCLUDE");
+    handles.values = parser.BindOption<std::vector<int>>("VALUES");
+    // How a value is read is code, so it is set on the bound node again
+    if (handles.values) {
+        handles.values->Delimiter(',');
+    }
+    handles.rate = parser.BindOption<double>("RATE");
+    handles.first = parser.BindPositional<std::string>("FIRST");
+    handles.rest = parser.BindPositional<std::vector<long>>("REST");
+    if (!handles.count || !handles.name || !handles.include ||
+        !handles.values || !handles.rate || !handles.first || !handles.rest) {
+        std::cerr << "a node of the saved schema didn't bind" << std::endl;
+        std::abort();
+    }
+    return handles;
+}
+
+/** Everything a parse leaves behind that the paths must agree on
+ */
+struct Snapshot {
+    bool parsed;
+    Parser::ErrorCode code;
+    std::size_t index;
+    std::string message;
+    std::vector<bool> matched;
+    int count;
+    std::string name;
+    std::vector<std::string> include;
+    std::vector<int> values;
+    // The bits of the double, so that NaNs compare equal
+    std::uint64_t rate;
+    std::string first;
+    std::vector<long> rest;
+
+    bool operator==(const Snapshot &other) const {
+        return parsed == other.parsed && code == other.code &&
+            index == other.index && message == other.message &&
+            matched == other.matched && count == other.count &&
+            name == other.name && include == other.include &&
+            values == other.values && rate == other.rate &&
+            first == other.first && rest == other.rest;
+    }
+};
+
+static std::uint64_t Bits(const double value) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+template <typename Node>
+static void Matched(Snapshot &snapshot, const Node &node,
+    const Parser::Result *result) {
+    snapshot.matched.push_back(result ? result->Matched(node) : node.Matched());
+}
+
+/** Read the parse out of the nodes, or out of a Result if there is one
+ */
+static Snapshot Take(const bool parsed, const Parser::ParseError &error,
+    const Handles &handles, const Parser::Result *result = nullptr) {
+    Snapshot snapshot;
+    snapshot.parsed = parsed;
+    snapshot.code = error.Code();
+    snapshot.index = parsed ? 0 : error.Index();
+    snapshot.message = error.Message();
+    Matched(snapshot, *handles.count, result);
+    Matched(snapshot, *handles.name, result);
+    Matched(snapshot, *handles.include, result);
+    Matched(snapshot, *handles.values, result);
+    Matched(snapshot, *handles.rate, result);
+    Matched(snapshot, *handles.first, result);
+    Matched(snapshot, *handles.rest, result);
+    if (result) {
+        snapshot.count = result->Value(*handles.count);
+        snapshot.name = result->Value(*handles.name);
+        snapshot.include = result->Value(*handles.include);
+        snapshot.values = result->Value(*handles.values);
+        snapshot.rate = Bits(result->Value(*handles.rate));
+        snapshot.first = result->Value(*handles.first);
+        snapshot.rest = result->Value(*handles.rest);
+    } else {
+        snapshot.count = handles.count->Value();
+        snapshot.name = handles.name->Value();
+        snapshot.include = handles.include->Value();
+        snapshot.values = handles.values->Value();
+        snapshot.rate = Bits(handles.rate->Value());
+        snapshot.first = handles.first->Value();
+        snapshot.rest = handles.rest->Value();
+    }
+    return snapshot;
+}
+
+/** Read a value by stream extraction, which must consume all of it, as the
+ * library did before it had its own conversions
+ */
+template <typename T>
+static bool Extract(const std::string &text, T &out) {
+    std::istringstream stream(text);
+    stream >> out;
+    return !stream.fail() && stream.rdbuf()->in_avail() <= 0;
+}
+
+template <typename T>
+static bool Extract(const std::string &text, std::vector<T> &out) {
+    T element = T();
+    if (!Extract(text, element)) {
+        return false;
+    }
+    out.push_back(element);
+    return true;
+}
+
+/** Read every comma-separated element of a value, or none of them
+ */
+static bool ExtractDelimited(
+    const std::string &text, std::vector<int> &out) {
+    const std::size_t size = out.size();
+    std::size_t start = 0;
+    while (true) {
+        const std::size_t comma = text.find(',', start);
+        if (!Extract(text.substr(start, comma - start), out)) {
+            out.resize(size);
+            return false;
+        }
+        if (comma == std::string::npos) {
+            return true;
+        }
+        start = comma + 1;
+    }
+}
+
+static bool StartsWith(const std::string &text, const std::string &prefix) {
+    return text.compare(0, prefix.size(), prefix) == 0;
+}
+
+/** The reference parse: the syntax read as plainly as possible, with each
+ * flag found by a scan over every option and each value read through a
+ * stream.  It shares nothing with the library but the error codes.
+ */
+class Reference {
+    public:
+    explicit Reference(const unsigned settings)
+        : _settings(settings),
+          _longPrefix(settings & CustomSyntax ? "++" : "--"),
+          _shortPrefix(settings & CustomSyntax ? "+" : "-"),
+          _terminator(settings & CustomSyntax ? "+" : "--") {
+        // Listed in the order they are added in, as the first one added is
+        // what an abbreviation of both reports
+        _options = {{'c', {"count"}}, {'n', {"name"}},
+            {'I', {"include", "includes"}}, {'v', {"values"}},
+            {'\0', {"rate", "number"}}};
+    }
+
+    Snapshot Parse(const std::vector<std::string> &args) {
+        _snapshot = Snapshot();
+        _snapshot.matched.assign(Names, false);
+        _rate = 0;
+        bool terminated = false;
+        std::size_t pending = None;
+        std::string pendingFlag;
+        bool pendingShort = false;
+        std::size_t pendingIndex = 0;
+        bool parsed = true;
+        for (std::size_t i = 0; parsed && i < args.size(); ++i) {
+            const std::string &arg = args[i];
+            if (pending != None) {
+                const std::size_t option = pending;
+                pending = None;
+                parsed = !(pendingShort ? (_settings & NoSeparateShort)
+                                        : (_settings & NoSeparateLong))
+                    ? StoreFlag(i, option, arg, pendingFlag)
+                    : Fail(Parser::ErrorCode::SeparateArgument, i,
+                          pendingFlag, option);
+            } else if (!terminated && arg == _terminator) {
+                terminated = true;
+            } else if (!terminated && arg.size() > _longPrefix.size() &&
+                StartsWith(arg, _longPrefix)) {
+                const std::string text = arg.substr(_longPrefix.size());
+                const std::size_t equals = text.find('=');
+                const std::string flag = text.substr(0, equals);
+                std::string whole;
+                const std::size_t option = FindLong(flag, whole);
+                if (option == None || option == Ambiguous) {
+                    parsed = Fail(option == None
+                            ? Parser::ErrorCode::UnmatchedFlag
+                            : Parser::ErrorCode::AmbiguousFlag,
+                        i, flag);
+                    continue;
+                }
+                _snapshot.matched[option] = true;
+                if (equals == std::string::npos) {
+                    pending = option;
+                    pendingFlag = whole;
+                    pendingShort = false;
+                    pendingIndex = i;
+                } else if (_settings & NoJoinedLong) {
+                    parsed = Fail(
+                        Parser::ErrorCode::JoinedArgument, i, whole, option);
+                } else {
+                    parsed =
+                        StoreFlag(i, option, text.substr(equals + 1), whole);
+                }
+            } else if (!terminated && arg.size() > _shortPrefix.size() &&
+                StartsWith(arg, _shortPrefix)) {
+                // Every option takes a value, so only the first flag of a
+                // cluster is a flag
+                const std::string flag = arg.substr(_shortPrefix.size(), 1);
+                const std::size_t option = FindShort(flag[0]);
+                if (option == None) {
+                    parsed =
+                        Fail(Parser::ErrorCode::UnmatchedFlag, i, flag);
+                    continue;
+                }
+                _snapshot.matched[option] = true;
+                const std::string value =
+                    arg.substr(_shortPrefix.size() + 1);
+                if (value.empty()) {
+                    pending = option;
+                    pendingFlag = flag;
+                    pendingShort = true;
+                    pendingIndex = i;
+                } else if (_settings & NoJoinedShort) {
+                    parsed = Fail(
+                        Parser::ErrorCode::JoinedArgument, i, flag, option);
+                } else {
+                    parsed = StoreFlag(i, option, value, flag);
+                }
+            } else {
+                parsed = StorePositional(i, arg);
+            }
+        }
+        if (parsed && pending != None) {
+            parsed = Fail(Parser::ErrorCode::MissingArgument, pendingIndex,
+                pendingFlag, pending);
+        }
+        _snapshot.parsed = parsed;
+        if (parsed) {
+            _snapshot.code = Parser::ErrorCode::None;
+        }
+        _snapshot.rate = Bits(_rate);
+        return _snapshot;
+    }
+
+    private:
+    static const std::size_t None = static_cast<std::size_t>(-1);
+    static const std::size_t Ambiguous = None - 1;
+    // The options, then FIRST and REST, in the order of Snapshot::matched
+    static const std::size_t First = 5;
+    static const std::size_t Rest = 6;
+    static const std::size_t Names = 7;
+
+    struct Flags {
+        char shortFlag;
+        std::vector<std::string> longFlags;
+    };
+
+    unsigned _settings;
+    std::string _longPrefix;
+    std::string _shortPrefix;
+    std::string _terminator;
+    std::vector<Flags> _options;
+    Snapshot _snapshot;
+    double _rate;
+
+    std::size_t FindShort(const char flag) const {
+        for (std::size_t i = 0; i < _options.size(); ++i) {
+            if (_options[i].shortFlag != '\0' &&
+                _options[i].shortFlag == flag) {
+                return i;
+            }
+        }
+        return None;
+    }
+
+    /** Find the option of a whole long flag, or failing that, of the only
+     * option with flags that it abbreviates, and give its flag
+     */
+    std::size_t FindLong(const std::string &flag, std::string &whole) const {
+        for (std::size_t i = 0; i < _options.size(); ++i) {
+            for (const std::string &longFlag : _options[i].longFlags) {
+                if (longFlag == flag) {
+                    whole = longFlag;
+                    return i;
+                }
+            }
+        }
+        if (!(_settings & Abbreviate) || flag.empty()) {
+            return None;
+        }
+        std::size_t found = None;
+        for (std::size_t i = 0; i < _options.size(); ++i) {
+            for (const std::string &longFlag : _options[i].longFlags) {
+                if (!StartsWith(longFlag, flag)) {
+                    continue;
+                }
+                if (found == None) {
+                    found = i;
+                    whole = longFlag;
+                } else if (found != i) {
+                    return Ambiguous;
+                }
+            }
+        }
+        return found;
+    }
+
+    bool Fail(const Parser::ErrorCode code, const std::size_t index,
+        const std::string &span, const std::size_t target = None) {
+        _snapshot.code = code;
+        _snapshot.index = index;
+        const std::string flag = "Flag '" + span;
+        switch (code) {
+            case Parser::ErrorCode::UnmatchedFlag:
+                _snapshot.message = "Flag could not be matched: " + span;
+                break;
+            case Parser::ErrorCode::AmbiguousFlag:
+                _snapshot.message = "Flag is ambiguous: " + span;
+                break;
+            case Parser::ErrorCode::JoinedArgument:
+                _snapshot.message = flag +
+                    "' was passed a joined argument, but these are disallowed";
+                break;
+            case Parser::ErrorCode::SeparateArgument:
+                _snapshot.message = flag +
+                    "' was passed a separate argument, but these are "
+                    "disallowed";
+                break;
+            case Parser::ErrorCode::MissingArgument:
+                _snapshot.message =
+                    flag + "' requires an argument but received none";
+                break;
+            case Parser::ErrorCode::InvalidValue:
+                _snapshot.message = span.empty()
+                    ? std::string("Positional '") +
+                        (target == First ? "FIRST" : "REST") +
+                        "' received an invalid value"
+                    : flag + "' received an invalid value";
+                break;
+            default:
+                _snapshot.message = "Passed in argument, but no positional "
+                                    "arguments were ready to receive it: " +
+                    span;
+                break;
+        }
+        return false;
+    }
+
+    bool Store(const std::size_t target, const std::string &value) {
+        switch (target) {
+            case 0: return Extract(value, _snapshot.count);
+            case 1: return Extract(value, _snapshot.name);
+            case 2: return Extract(value, _snapshot.include);
+            case 3: return ExtractDelimited(value, _snapshot.values);
+            case 4: return Extract(value, _rate);
+            case First: return Extract(value, _snapshot.first);
+            default: return Extract(value, _snapshot.rest);
+        }
+    }
+
+    bool StoreFlag(const std::size_t index, const std::size_t option,
+        const std::string &value, const std::string &flag) {
+        return Store(option, value) ||
+            Fail(Parser::ErrorCode::InvalidValue, index, flag, option);
+    }
+
+    bool StorePositional(const std::size_t index, const std::string &arg) {
+        // REST takes every positional once FIRST has one
+        const std::size_t target = _snapshot.matched[First] ? Rest : First;
+        if (!Store(target, arg)) {
+            return Fail(Parser::ErrorCode::InvalidValue, index, std::string(),
+                target);
+        }
+        _snapshot.matched[target] = true;
+        return true;
+    }
+};
+
+/** The parsers of a setting that are kept across inputs, so that reuse is
+ * fuzzed too
+ */
+struct Fixture {
+    Parser frozen;
+    Handles frozenHandles;
+    Parser::Result result;
+    Parser lazy;
+    Handles lazyHandles;
+    std::vector<unsigned char> blob;
+    Parser loaded;
+    Handles loadedHandles;
+
+    explicit Fixture(const unsigned settings)
+        : frozenHandles(Build(frozen, settings)),
+          result(frozen.Freeze()),
+          lazyHandles(Build(lazy.Lazy(true), settings)) {
+        lazy.Freeze();
+        if (!frozen.SaveSchema(blob) ||
+            !loaded.LoadSchema(blob.data(), blob.size())) {
+            std::cerr << "the schema didn't save and load" << std::endl;
+            std::abort();
+        }
+        loadedHandles = Bind(loaded);
+    }
+};
+
+/** Quote an argument as a single word of a command string
+ */
+static void Quote(std::string &command, const std::string &arg) {
+    command += '\'';
+    for (const char c : arg) {
+        if (c == '\'') {
+            command += "'\\''";
+        } else {
+            command += c;
+        }
+    }
+    command += "' ";
+}
+
+static void Mismatch(const char *path, const std::vector<std::string> &args,
+    const Snapshot &reference, const Snapshot &snapshot) {
+    std::cerr << path << " differs from the reference parse of";
+    for (const std::string &arg : args) {
+        std::cerr << " [" << arg << "]";
+    }
+    std::cerr << "\n  reference: " << reference.parsed << " "
+              << reference.message << "\n  " << path << ": "
+              << snapshot.parsed << " " << snapshot.message << std::endl;
+    std::abort();
+}
+
+static void Expect(const char *path, const std::vector<std::string> &args,
+    const Snapshot &reference, const Snapshot &snapshot) {
+    if (!(snapshot == reference)) {
+        Mismatch(path, args, reference, snapshot);
+    }
+}
+
+static Fixture &GetFixture(const unsigned settings) {
+    static std::unique_ptr<Fixture> fixtures[AllSettings];
+    if (!fixtures[settings]) {
+        fixtures[settings].reset(new Fixture(settings));
+    }
+    return *fixtures[settings];
+}
+
+/** Split an input into its settings and its arguments
+ */
+static unsigned Decode(const std::uint8_t *data, const std::size_t size,
+    std::vector<std::string> &args) {
+    args.clear();
+    if (size == 0) {
+        return 0;
+    }
+    const char *const begin = reinterpret_cast<const char *>(data) + 1;
+    const char *const end = reinterpret_cast<const char *>(data) + size;
+    for (const char *word = begin; word < end;) {
+        const char *const stop =
+            static_cast<const char *>(std::memchr(word, '\0', end - word));
+        const char *const wordEnd = stop ? stop : end;
+        args.emplace_back(word, wordEnd);
+        word = wordEnd + 1;
+    }
+    return data[0] % AllSettings;
+}
+
+static void Run(const std::uint8_t *data, const std::size_t size) {
+    std::vector<std::string> args;
+    const unsigned settings = Decode(data, size, args);
+    Fixture &fixture = GetFixture(settings);
+
+    Reference naive(settings);
+    const Snapshot reference = naive.Parse(args);
+
+    Parser parser;
+    const Handles handles = Build(parser, settings);
+    Expect("eager", args, reference,
+        Take(parser.ParseArgs(args), parser.LastError(), handles));
+    Expect("frozen", args, reference,
+        Take(fixture.frozen.ParseArgs(args), fixture.frozen.LastError(),
+            fixture.frozenHandles));
+    Expect("result", args, reference,
+        Take(fixture.frozen.ParseArgs(args, fixture.result),
+            fixture.result.LastError(), fixture.frozenHandles,
+            &fixture.result));
+
+    std::vector<const char *> argv{"fuzz"};
+    for (const std::string &arg : args) {
+        argv.push_back(arg.c_str());
+    }
+    const Parser::Result &result = fixture.result;
+    Expect("cli result", args, reference,
+        Take(fixture.frozen.ParseCLI(static_cast<int>(argv.size()),
+                 argv.data(), fixture.result),
+            result.LastError(), fixture.frozenHandles, &result));
+
+    std::string command;
+    for (const std::string &arg : args) {
+        Quote(command, arg);
+    }
+    Expect("command", args, reference,
+        Take(fixture.frozen.ParseCommand(command), fixture.frozen.LastError(),
+            fixture.frozenHandles));
+
+    Expect("loaded", args, reference,
+        Take(fixture.loaded.ParseArgs(args), fixture.loaded.LastError(),
+            fixture.loadedHandles));
+
+    // A lazy parse only checks the values that it keeps, and those only in
+    // Validate(), so it can only be held to the reference as a whole when no
+    // value was invalid
+    Parser &lazy = fixture.lazy;
+    const bool lazyParsed = lazy.ParseArgs(args);
+    if (reference.code == Parser::ErrorCode::InvalidValue) {
+        return;
+    }
+    if (!lazyParsed) {
+        Expect("lazy", args, reference,
+            Take(lazyParsed, lazy.LastError(), fixture.lazyHandles));
+        return;
+    }
+    const unsigned threads = 1 + data[0] / AllSettings % 2;
+    const bool valid = lazy.Validate(threads);
+    Expect("lazy", args, reference,
+        Take(valid, lazy.LastError(), fixture.lazyHandles));
+}
+
+extern "C" int LLVMFuzzerTestOneInput(
+    const std::uint8_t *data, std::size_t size) {
+    Run(data, size);
+    return 0;
+}
+
+#ifndef ARGSPLUS_LIBFUZZER
+static bool Read(const char *path, std::string &input) {
+    std::ifstream file(path, std::ios::binary);
+    input.assign(std::istreambuf_iterator<char>(file),
+        std::istreambuf_iterator<char>());
+    return !file.bad() && file.is_open();
+}
+
+static const std::uint8_t *Bytes(const std::string &input) {
+    return reinterpret_cast<const std::uint8_t *>(input.data());
+}
+
+/** Run every input with random bytes flipped, inserted, and removed, for
+ * when libFuzzer isn't there
+ */
+static void Mutate(const std::vector<std::string> &inputs,
+    const unsigned long rounds) {
+    // Mostly the bytes that the syntax cares about, and the terminating NUL
+    // that separates arguments
+    static const char bytes[] = "-+=,.'\\ 0123456789cenIvr";
+    std::mt19937 engine(12345);
+    for (unsigned long round = 0; round < rounds; ++round) {
+        std::string input = inputs[engine() % inputs.size()];
+        for (unsigned edits = 1 + engine() % 4; edits > 0; --edits) {
+            const std::size_t at = input.empty() ? 0 : engine() % input.size();
+            const char byte = bytes[engine() % sizeof(bytes)];
+            switch (engine() % 3) {
+                case 0: input.insert(at, 1, byte); break;
+                case 1: if (!input.empty()) input.erase(at, 1); break;
+                default: if (!input.empty()) input[at] = byte; break;
+            }
+        }
+        Run(Bytes(input), input.size());
+    }
+}
+
+/** Time the fast path over every input, and compare its time per argument
+ * to the last line of the baseline file
+ */
+static int Time(const std::vector<std::string> &inputs,
+    const char *baselinePath, const double tolerance) {
+    using Clock = std::chrono::steady_clock;
+    std::vector<std::vector<std::string>> parses;
+    std::vector<unsigned> settings;
+    std::size_t arguments = 0;
+    for (const std::string &input : inputs) {
+        parses.emplace_back();
+        settings.push_back(Decode(Bytes(input), input.size(), parses.back()));
+        arguments += parses.back().size();
+        GetFixture(settings.back());
+    }
+    if (arguments == 0) {
+        std::cerr << "the corpus has no arguments" << std::endl;
+        return 1;
+    }
+
+    std::size_t iterations = 0;
+    const Clock::time_point start = Clock::now();
+    Clock::duration elapsed;
+    do {
+        for (std::size_t i = 0; i < parses.size(); ++i) {
+            GetFixture(settings[i]).frozen.ParseArgs(parses[i]);
+        }
+        ++iterations;
+        elapsed = Clock::now() - start;
+    } while (elapsed < std::chrono::milliseconds(500));
+    const double nanoseconds =
+        std::chrono::duration<double, std::nano>(elapsed).count() /
+        iterations / arguments;
+    std::cout << nanoseconds << " ns/arg over " << arguments
+              << " arguments" << std::endl;
+
+    std::ifstream file(baselinePath ? baselinePath : "");
+    std::string line;
+    std::string last;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line[0] != '#') {
+            last = line;
+        }
+    }
+    if (last.empty()) {
+        return 0;
+    }
+    // Each line is a commit and its time per argument
+    std::istringstream fields(last);
+    std::string commit;
+    double baseline = 0;
+    fields >> commit >> baseline;
+    if (!fields || baseline <= 0) {
+        std::cerr << "unreadable baseline: " << last << std::endl;
+        return 1;
+    }
+    const double change = (nanoseconds / baseline - 1) * 100;
+    std::cout << change << "% against " << commit << std::endl;
+    return change > tolerance ? 1 : 0;
+}
+
+static void Usage() {
+    std::cerr << "usage: fuzz [FILE...]\n"
+                 "       fuzz --mutate ROUNDS FILE...\n"
+                 "       fuzz --time BASELINE TOLERANCE% FILE...\n"
+                 "With no files, one input is read from stdin."
+              << std::endl;
+}
+
+int main(int argc, char **argv) {
+    std::vector<std::string> args(argv + 1, argv + argc);
+    std::string mode;
+    std::vector<std::string> options;
+    if (!args.empty() && (args[0] == "--mutate" || args[0] == "--time")) {
+        mode = args[0];
+        const std::size_t count = mode == "--mutate" ? 1 : 2;
+        if (args.size() < 1 + count) {
+            Usage();
+            return 2;
+        }
+        options.assign(args.begin() + 1, args.begin() + 1 + count);
+        args.erase(args.begin(), args.begin() + 1 + count);
+    }
+
+    std::vector<std::string> inputs;
+    if (args.empty()) {
+        inputs.emplace_back(std::istreambuf_iterator<char>(std::cin),
+            std::istreambuf_iterator<char>());
+    }
+    for (const std::string &path : args) {
+        inputs.emplace_back();
+        if (!Read(path.c_str(), inputs.back())) {
+            std::cerr << "unreadable input: " << path << std::endl;
+            return 2;
+        }
+    }
+
+    if (mode == "--time") {
+        return Time(inputs, options[0].c_str(),
+            std::strtod(options[1].c_str(), nullptr));
+    }
+    for (const std::string &input : inputs) {
+        Run(Bytes(input), input.size());
+    }
+    if (mode == "--mutate") {
+        Mutate(inputs, std::strtoul(options[0].c_str(), nullptr, 10));
+    }
+    std::cout << inputs.size() << " inputs agree on every path" << std::endl;
+    return 0;
+}
+#endif
@@ -2,11 +2,1425 @@
  * This code is released under the license described in the LICENSE file
  */
 
+#include <atomic>
+#include <clocale>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <new>
+#include <thread>
 
+// Build the instrumentation in, so that its counters are checked too
+#define ARGSPLUS_INSTRUMENT
 #include <argsplus.hxx>
 
+// Count every allocation and deallocation, so that tests can check how much
+// parsing costs and that everything is given back
+static std::atomic<std::size_t> allocations(0);
+static std::atomic<std::size_t> deallocations(0);
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    ++allocations;
+    return std::malloc(size ? size : 1);
+}
+
+void *operator new(std::size_t size) {
+    if (void *ptr = operator new(size, std::nothrow)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+// GCC takes the inlined free() below for a mismatch with operator new
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void *ptr) noexcept {
+    if (ptr) {
+        ++deallocations;
+        std::free(ptr);
+    }
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+    operator delete(ptr);
+}
+
+// C++14 deletes through the sized overload where the size is known
+#ifdef __cpp_sized_deallocation
+void operator delete(void *ptr, std::size_t) noexcept { operator delete(ptr); }
+#endif
+
+static int failures = 0;
+
+static void Check(const bool condition, const char *description) {
+    if (!condition) {
+        std::cerr << "FAILED: " << description << std::endl;
+        ++failures;
+    }
+}
+
+// ParseCLI must view argv in place, where copying it into a List<String>
+// costs at least one allocation per argument that doesn't fit in the small
+// string buffer.
+static void TestParseCLIAllocations() {
+    const char *const argv[] = {"prog", "--a-rather-long-option-name=5",
+        "--another-rather-long-option", "6", "-s7"};
+    const int argc = sizeof(argv) / sizeof(*argv);
+
+    argsplus::ArgumentParser<> parser("", "", "prog");
+    const auto &first = parser.AddOption<int>(
+        "FIRST", {"a-rather-long-option-name"});
+    const auto &second = parser.AddOption<int>(
+        "SECOND", {"another-rather-long-option"});
+    const auto &third = parser.AddOption<int>("THIRD", {'s'});
+
+    const std::size_t before = allocations;
+    const bool parsed = parser.ParseCLI(argc, argv);
+    const std::size_t inPlace = allocations - before;
+    Check(parsed, "ParseCLI parses argv");
+    Check(first.Value() == 5 && second.Value() == 6 && third.Value() == 7,
+        "ParseCLI assigns values");
+
+    const std::size_t copyBefore = allocations;
+    const std::vector<std::string> args(argv + 1, argv + argc);
+    parser.ParseArgs(args);
+    const std::size_t copied = allocations - copyBefore;
+
+    Check(inPlace < copied, "ParseCLI allocates less than copying argv");
+    Check(inPlace == 0, "ParseCLI does not allocate for argv chunks");
+}
+
+// Counts the blocks that parsers take for their arena
+static std::size_t arenaBlocks = 0;
+
+template <typename T>
+struct BlockAllocator : std::allocator<T> {
+    T *allocate(const std::size_t n) {
+        ++arenaBlocks;
+        return std::allocator<T>::allocate(n);
+    }
+};
+
+// Nodes, with their names, help, and flags, are all in the parser's arena,
+// whose blocks grow, so that building and tearing down a parser takes a few
+// dozen allocations however many options it has
+static void TestParserAllocations() {
+    std::vector<std::string> names;
+    std::vector<std::string> flags;
+    for (int i = 0; i < 1000; ++i) {
+        const std::string number = std::to_string(i);
+        names.push_back("A-RATHER-LONG-OPTION-NAME-" + number);
+        flags.push_back("a-rather-long-option-flag-" + number);
+    }
+    const char *const help = "Help that doesn't fit in a small string buffer";
+
+    const std::size_t before = allocations;
+    const std::size_t freedBefore = deallocations;
+    {
+        argsplus::ArgumentParser<> parser("A description", "", "prog");
+        for (int i = 0; i < 1000; ++i) {
+            parser.AddOption<int>(names[i], {flags[i], flags[i]}).Help(help);
+        }
+        parser.AddPositional<std::vector<std::string>>("POSITIONAL")
+            .Help(help);
+        parser.Freeze();
+        Check(parser.Error().empty(),
+            "flags that one option repeats are only registered once");
+    }
+    const std::size_t allocated = allocations - before;
+    Check(allocated < 100,
+        "building and tearing down a parser takes a bounded number of "
+        "allocations");
+    Check(deallocations - freedBefore == allocated,
+        "tearing down a parser frees everything it allocated");
+
+    {
+        argsplus::ArgumentParser<std::string, char, std::vector,
+            std::unordered_set, std::unordered_map, BlockAllocator>
+            parser;
+        for (int i = 0; i < 1000; ++i) {
+            parser.AddOption<int>(names[i], {flags[i]}).Help(help);
+        }
+    }
+    Check(arenaBlocks > 0 && arenaBlocks < 16,
+        "the arena takes a few growing blocks from the Allocator");
+
+    // Help given to a node after its parser moves goes to the new arena, and
+    // is freed with it
+    std::aligned_storage<sizeof(argsplus::ArgumentParser<>),
+        alignof(argsplus::ArgumentParser<>)>::type storage;
+    const std::size_t moveBefore = allocations;
+    const std::size_t moveFreedBefore = deallocations;
+    bool found = false;
+    {
+        argsplus::ArgumentParser<> *original =
+            new (&storage) argsplus::ArgumentParser<>;
+        auto &option = original->AddOption<int>("NUMBER", {'n'});
+        argsplus::ArgumentParser<> moved(std::move(*original));
+        original->~ArgumentParser();
+        std::memset(&storage, 0, sizeof(storage));
+        option.Help(help);
+        found = moved.Help().find(help) != std::string::npos;
+    }
+    Check(found && allocations - moveBefore == deallocations - moveFreedBefore,
+        "nodes find the arena of a moved parser");
+}
+
+// The arithmetic fast path must accept exactly what stream extraction of the
+// whole value accepts, and leave the same value behind when it doesn't
+template <typename T>
+static void CheckNumber(const std::string &value, const bool accepted) {
+    argsplus::ArgumentParser<> parser;
+    const auto &number = parser.AddOption<T>("NUMBER", {"number"});
+    const std::vector<std::string> args{"--number=" + value};
+    Check(parser.ParseArgs(args) == accepted, value.c_str());
+    std::istringstream stream(value);
+    T expected = T();
+    stream >> expected;
+    Check(number.Value() == expected,
+        ("the value left by " + value).c_str());
+}
+
+static void TestNumericStrictness() {
+    CheckNumber<int>("42", true);
+    CheckNumber<int>(" 42", true);
+    CheckNumber<int>("-2147483648", true);
+    CheckNumber<int>("2147483648", false);
+    CheckNumber<int>("42 ", false);
+    CheckNumber<int>("4x", false);
+    CheckNumber<int>("0x10", false);
+    CheckNumber<int>("+", false);
+    CheckNumber<int>("", false);
+    CheckNumber<unsigned int>("-1", true);
+    CheckNumber<unsigned int>("4294967296", false);
+    CheckNumber<unsigned long long>("18446744073709551615", true);
+    CheckNumber<double>("1e5", true);
+    CheckNumber<double>(".5", true);
+    CheckNumber<double>("1e999", false);
+    CheckNumber<double>("1e", false);
+    CheckNumber<double>("2.e+", false);
+    CheckNumber<double>("1e5e", false);
+    CheckNumber<double>("inf", false);
+    CheckNumber<double>("nan", false);
+    CheckNumber<double>("0x1p3", false);
+
+    // Floats read "." whatever the C locale, where one with "," is installed
+    for (const char *name : {"de_DE.UTF-8", "de_DE.utf8", "fr_FR.UTF-8"}) {
+        if (std::setlocale(LC_NUMERIC, name)) {
+            CheckNumber<double>("2.5", true);
+            CheckNumber<double>("2,5", false);
+            std::setlocale(LC_NUMERIC, "C");
+            break;
+        }
+    }
+}
+
+static void TestListPositional() {
+    argsplus::ArgumentParser<> parser;
+    const auto &count = parser.AddPositional<int>("COUNT");
+    const auto &files = parser.AddPositional<std::vector<std::string>>("FILES");
+    const auto &extra = parser.AddPositional<int>("EXTRA").Default(-1);
+    const std::vector<std::string> args{"3", "a", "--", "b", "-c"};
+    Check(parser.ParseArgs(args), "list positional parses");
+    Check(count.Value() == 3, "positional before a list is filled first");
+    Check(files.Value() == std::vector<std::string>({"a", "b", "-c"}),
+        "list positional absorbs the remaining chunks");
+    Check(!extra.Matched() && extra.Value() == -1,
+        "positional after a list is never filled");
+}
+
+// Once a frozen parser has warmed up, parsing a similar command line again
+// must not allocate at all
+static void TestFrozenReuse() {
+    argsplus::ArgumentParser<> parser;
+    const auto &name = parser.AddOption<std::string>("NAME", {'n', "name"})
+                           .Default("a default name that is long");
+    const auto &count = parser.AddOption<int>("COUNT", {'c'}).Default(1);
+    const auto &ids = parser.AddPositional<std::vector<int>>("IDS");
+    parser.Freeze();
+
+    const char *const spaced[] = {"prog", "--name=a name with spaces"};
+    Check(!parser.ParseCLI(2, spaced), "string values are single words");
+    const char *const args[] = {"prog", "--name=some-rather-long-name",
+        "-c5", "1", "2", "3"};
+    Check(parser.ParseCLI(6, args), "frozen parser parses");
+    Check(name.Value() == "some-rather-long-name" && count.Value() == 5 &&
+            ids.Value() == std::vector<int>({1, 2, 3}),
+        "frozen parser assigns values");
+
+    const std::size_t before = allocations;
+    Check(parser.ParseCLI(6, args), "frozen parser parses again");
+    Check(allocations == before, "steady-state frozen parse doesn't allocate");
+    Check(count.Value() == 5 && ids.Value().size() == 3,
+        "frozen parser resets between parses");
+
+    parser.Reset();
+    Check(name.Value() == name.Default() && count.Value() == 1 &&
+            ids.Value().empty() && !count.Matched(),
+        "Reset restores defaults");
+    parser.AddOption<int>("LATE", {'l'});
+    Check(!parser.ParseCLI(6, args), "frozen parser refuses new options");
+}
+
+// One frozen parser can be shared by threads that parse into their own
+// Results, leaving the parser itself untouched
+static void TestSharedResults() {
+    argsplus::ArgumentParser<> parser;
+    const auto &number = parser.AddOption<int>("NUMBER", {'n', "number"});
+    const auto &words =
+        parser.AddPositional<std::vector<std::string>>("WORDS");
+    parser.Freeze();
+
+    bool ok[4] = {};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&parser, &number, &words, &ok, t] {
+            argsplus::ArgumentParser<>::Result result(parser);
+            bool good = true;
+            for (int i = 0; i < 1000; ++i) {
+                const std::vector<std::string> args{
+                    "-n", std::to_string(t * 1000 + i), "x", "y"};
+                good = good && parser.ParseArgs(args, result) &&
+                    result.Value(number) == t * 1000 + i &&
+                    result.Value(words).size() == 2 && result.Matched(number);
+            }
+            const std::vector<std::string> bad{"-n", "x"};
+            ok[t] = good && !parser.ParseArgs(bad, result) &&
+                result.Error() == "Flag 'n' received an invalid value";
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    Check(ok[0] && ok[1] && ok[2] && ok[3], "threads parse into Results");
+    Check(!number.Matched() && words.Value().empty() && parser.Error().empty(),
+        "parsing into a Result leaves the parser alone");
+}
+
+// A lazy parser only converts the values that are read, and Validate() finds
+// the earliest one that an eager parse would have rejected
+static void TestLazyValues() {
+    argsplus::ArgumentParser<> parser;
+    parser.Lazy(true);
+    const auto &count = parser.AddOption<int>("COUNT", {'c', "count"});
+    const auto &ratio = parser.AddOption<double>("RATIO", {'r'});
+    const auto &ids = parser.AddPositional<std::vector<int>>("IDS");
+    const std::vector<std::string> args{
+        "--count=x", "-c", "7", "-r", "y", "1", "z", "3"};
+    Check(parser.ParseArgs(args), "lazy parse defers conversion");
+    Check(count.Value() == 7, "lazy parse keeps only the last scalar value");
+    Check(!parser.Validate() &&
+            parser.Error() == "Flag 'r' received an invalid value",
+        "Validate reports the earliest invalid value");
+
+    parser.Reset();
+    const std::vector<std::string> good{"-r", "0.5", "1", "2"};
+    Check(parser.ParseArgs(good) && parser.Validate(), "lazy values validate");
+    Check(ratio.Value() == 0.5 && ids.Value() == std::vector<int>({1, 2}),
+        "lazy values convert on access");
+}
+
+// A batch of argument vectors parses into columns, the same with one thread
+// as with several
+static void TestBatch() {
+    argsplus::ArgumentParser<> parser;
+    const auto &number = parser.AddOption<int>("NUMBER", {'n'});
+    const auto &name = parser.AddPositional<std::string>("NAME");
+    parser.Freeze();
+
+    std::vector<std::vector<std::string>> vectors;
+    for (int i = 0; i < 300; ++i) {
+        const std::string value = std::to_string(i);
+        vectors.push_back(i % 3
+                ? std::vector<std::string>{"-n", value, "x" + value}
+                : std::vector<std::string>{"y"});
+    }
+    vectors[250] = {"-n", "bad"};
+    for (const unsigned threads : {1u, 4u}) {
+        argsplus::ArgumentParser<>::Batch batch(parser);
+        Check(!parser.ParseBatch(vectors, batch, threads) &&
+                batch.Size() == 300,
+            "batch parses every record");
+        bool good = true;
+        for (int i = 0; i < 300; ++i) {
+            if (i == 250) {
+                continue;
+            }
+            good = good && batch.Matched(number, i) == (i % 3 != 0) &&
+                batch.Values(number)[i] == (i % 3 ? i : 0) &&
+                batch.Values(name)[i] ==
+                    (i % 3 ? "x" + std::to_string(i) : "y");
+        }
+        Check(good, "batch columns hold every record");
+        Check(batch.Failures().size() == 1 &&
+                batch.Failures()[0].record == 250 &&
+                batch.Failures()[0].error ==
+                    "Flag 'n' received an invalid value",
+            "batch lists failed records");
+    }
+
+    argsplus::ArgumentParser<>::Batch records(parser);
+    const char text[] = "-n\0" "1\0a\n\nb\n-n2\0c";
+    const std::string buffer(text, sizeof(text) - 1);
+    Check(parser.ParseRecords(buffer, records) && records.Size() == 4,
+        "records parse from a buffer");
+    Check(records.Values(number) == std::vector<int>({1, 0, 0, 2}) &&
+            records.Values(name) ==
+                std::vector<std::string>({"a", "", "b", "c"}),
+        "records split into arguments");
+}
+
+static void WriteFile(const char *path, const std::string &contents) {
+    std::ofstream(path, std::ios::binary) << contents;
+}
+
+// Response files expand in place, with quoting and nesting, and their values
+// are converted before the file goes away even when parsing lazily
+static void TestResponseFiles() {
+    WriteFile("argsplus-outer.rsp",
+        "-n 3 'q\"uote' @argsplus-inner.rsp \"a\\\"b\" c\\'d");
+    WriteFile("argsplus-inner.rsp", "--name=inner\n");
+    WriteFile("argsplus-loop.rsp", "@argsplus-loop.rsp");
+    WriteFile("argsplus-quote.rsp", "'open");
+
+    argsplus::ArgumentParser<> parser;
+    parser.ResponseFiles(true).Lazy(true);
+    const auto &number = parser.AddOption<int>("NUMBER", {'n'});
+    const auto &name = parser.AddOption<std::string>("NAME", {"name"});
+    const auto &words =
+        parser.AddPositional<std::vector<std::string>>("WORDS");
+    const std::vector<std::string> args{"@argsplus-outer.rsp", "--", "@x"};
+    Check(parser.ParseArgs(args), "response files parse");
+    Check(number.Value() == 3 && name.Value() == "inner",
+        "response files hold options");
+    Check(words.Value() ==
+            std::vector<std::string>({"q\"uote", "a\"b", "c'd", "@x"}),
+        "response files are unquoted");
+
+    parser.Reset();
+    const std::vector<std::string> loop{"@argsplus-loop.rsp"};
+    Check(!parser.ParseArgs(loop) &&
+            parser.Error() ==
+                "Response files are nested too deeply: argsplus-loop.rsp",
+        "response files stop a loop");
+    const std::vector<std::string> quote{"@argsplus-quote.rsp"};
+    Check(!parser.ParseArgs(quote) &&
+            parser.Error() ==
+                "Response file has an unterminated quote: argsplus-quote.rsp",
+        "response files report unterminated quotes");
+    const std::vector<std::string> missing{"@argsplus-missing.rsp"};
+    Check(!parser.ParseArgs(missing) &&
+            parser.Error() ==
+                "Could not read response file: argsplus-missing.rsp",
+        "response files report missing files");
+    parser.Reset();
+    const std::vector<std::string> value{"--name", "@argsplus-inner.rsp"};
+    Check(parser.ParseArgs(value) && name.Value() == "@argsplus-inner.rsp",
+        "separate values are never response files");
+
+    for (const char *path : {"argsplus-outer.rsp", "argsplus-inner.rsp",
+             "argsplus-loop.rsp", "argsplus-quote.rsp"}) {
+        std::remove(path);
+    }
+}
+
+// Command strings split on the parser's quoting rules, past the SIMD block
+// sizes, and lazily only where the words view the command itself
+static void TestParseCommand() {
+    argsplus::ArgumentParser<> parser;
+    parser.Lazy(true);
+    const auto &number = parser.AddOption<int>("NUMBER", {'n', "number"});
+    const auto &words =
+        parser.AddPositional<std::vector<std::string>>("WORDS");
+    const std::string command = "  a-word-that-is-longer-than-a-block\t"
+                                "--number=5 \"quoted\\\"word\"\n"
+                                "a-second-word-that-is-longer-than-a-block"
+                                "'with\\backslash' escaped\\x \\\\  ";
+    Check(parser.ParseCommand(command) && parser.Validate(),
+        "command strings parse");
+    Check(number.Value() == 5, "command strings hold options");
+    Check(words.Value() ==
+            std::vector<std::string>({"a-word-that-is-longer-than-a-block",
+                "quoted\"word",
+                "a-second-word-that-is-longer-than-a-blockwith\\backslash",
+                "escapedx", "\\"}),
+        "command strings split into words");
+
+    parser.Reset();
+    Check(!parser.ParseCommand("-n 'x") &&
+            parser.Error() == "Command has an unterminated quote",
+        "command strings report unterminated quotes");
+}
+
+// Other prefixes classify chunks the same way as the usual dashes
+static void TestCustomSyntax() {
+    argsplus::ArgumentParser<> parser;
+    parser.LongPrefix("//").ShortPrefix("/");
+    parser.LongSeparator(":").OptionTerminator("..");
+    const auto &number = parser.AddOption<int>("NUMBER", {'n', "number"});
+    const auto &flag = parser.AddOption<int>("FLAG", {'f'});
+    const auto &words =
+        parser.AddPositional<std::vector<std::string>>("WORDS");
+    const std::vector<std::string> args{
+        "//number:4", "/f", "2", "-x", "/", "..", "//number:5"};
+    Check(parser.ParseArgs(args), "custom syntax parses");
+    Check(number.Value() == 4 && flag.Value() == 2,
+        "custom prefixes mark flags");
+    Check(words.Value() ==
+            std::vector<std::string>({"-x", "/", "//number:5"}),
+        "custom terminator ends flags");
+}
+
+// Long flags are found in a trie, which also resolves unique abbreviations
+static void TestLongFlags() {
+    argsplus::ArgumentParser<> parser;
+    const auto &verbose =
+        parser.AddOption<int>("VERBOSE", {"verbose", "verbosity"});
+    const auto &verb = parser.AddOption<int>("VERB", {"verb"});
+    const auto &version = parser.AddOption<int>("VERSION", {"version"});
+    const std::vector<std::string> abbreviated{"--verbo=1", "--verb", "2"};
+    Check(!parser.ParseArgs(abbreviated) &&
+            parser.Error() == "Flag could not be matched: verbo",
+        "abbreviations are off by default");
+
+    parser.Abbreviations(true);
+    Check(parser.ParseArgs(abbreviated) && verbose.Value() == 1 &&
+            verb.Value() == 2,
+        "aliases share an abbreviation, and whole flags win");
+    const std::vector<std::string> unique{"--vers", "3"};
+    Check(parser.ParseArgs(unique) && version.Value() == 3,
+        "unique prefixes are abbreviations");
+    const std::vector<std::string> ambiguous{"--ver=4"};
+    Check(!parser.ParseArgs(ambiguous) &&
+            parser.Error() == "Flag is ambiguous: ver",
+        "shared prefixes are ambiguous");
+    const std::vector<std::string> missing{"--verbosely=5"};
+    Check(!parser.ParseArgs(missing) &&
+            parser.Error() == "Flag could not be matched: verbosely",
+        "flags longer than any match fail");
+    const std::vector<std::string> pending{"--versi"};
+    Check(!parser.ParseArgs(pending) &&
+            parser.Error() ==
+                "Flag 'version' requires an argument but received none",
+        "abbreviated flags report their whole name");
+
+    // A rejected duplicate is a schema error, so only completion, which
+    // doesn't check the schema, still shows how an abbreviation resolves
+    argsplus::ArgumentParser<> duplicate;
+    duplicate.Abbreviations(true);
+    const auto &count = duplicate.AddOption<int>("COUNT", {"count"});
+    duplicate.AddOption<int>("COPY", {"count"});
+    argsplus::ArgumentParser<>::Completion completion;
+    const std::vector<std::string> prefix{"--cou"};
+    duplicate.Complete(prefix, "", completion);
+    Check(!duplicate.ParseArgs(prefix) && completion.option == &count,
+        "rejected duplicates leave abbreviations alone");
+}
+
+// Short flags of every byte value resolve through the dense table
+static void TestShortFlags() {
+    argsplus::ArgumentParser<> parser;
+    parser.AddOption<int>("X", {'x'});
+    parser.AddOption<int>("HIGH", {'\xe9'});
+    parser.AddOption<int>("DUPLICATE", {'x'});
+    const std::vector<std::string> args{"-x1", "-\xe9", "2"};
+    Check(!parser.ParseArgs(args) &&
+            parser.Error() == "Flag 'x' was registered to more than one option",
+        "duplicate short flags are schema errors");
+
+    argsplus::ArgumentParser<> bundles;
+    const auto &v = bundles.AddOption<int>("V", {'v'});
+    const auto &file = bundles.AddOption<std::string>("FILE", {'f'});
+    const auto &z = bundles.AddOption<int>("Z", {'\xff'});
+    const std::vector<std::string> bundled{"-v3", "-\xff", "4", "-ffile"};
+    Check(bundles.ParseArgs(bundled) && v.Value() == 3 && z.Value() == 4 &&
+            file.Value() == "file",
+        "short flags resolve by byte");
+    const std::vector<std::string> unknown{"-q"};
+    Check(!bundles.ParseArgs(unknown) &&
+            bundles.Error() == "Flag could not be matched: q",
+        "unknown short flags fail");
+
+    // The moved-from parser's storage is wiped, so that views of it show
+    std::aligned_storage<sizeof(argsplus::ArgumentParser<>),
+        alignof(argsplus::ArgumentParser<>)>::type storage;
+    argsplus::ArgumentParser<> *original =
+        new (&storage) argsplus::ArgumentParser<>;
+    original->Lazy(true);
+    original->AddOption<int>("N", {'n'});
+    const std::vector<std::string> invalid{"-n", "x"};
+    const bool parsed = original->ParseArgs(invalid);
+    argsplus::ArgumentParser<> moved(std::move(*original));
+    original->~ArgumentParser();
+    std::memset(&storage, 0, sizeof(storage));
+    Check(parsed && !moved.Validate() &&
+            moved.Error() == "Flag 'n' received an invalid value",
+        "lazy short flags outlive moving the parser");
+}
+
+// Errors are recorded in pieces, rendered only on request, and rejecting the
+// same kind of input again costs no allocations
+static void TestStructuredErrors() {
+    using Parser = argsplus::ArgumentParser<>;
+    Parser parser;
+    const auto &number = parser.AddOption<int>("NUMBER", {'n', "number"});
+    const auto &name = parser.AddPositional<int>("NAME");
+    parser.Freeze();
+
+    const char *const bad[] = {"prog", "-n", "1", "--number=some-bad-value"};
+    Check(!parser.ParseCLI(4, bad), "bad values fail");
+    const Parser::ParseError &error = parser.LastError();
+    Check(error.Code() == Parser::ErrorCode::InvalidValue &&
+            error.Index() == 2 && error.Target() == &number &&
+            error.Span() == "number",
+        "errors keep their code, index, target, and span");
+
+    const std::size_t before = allocations;
+    Check(!parser.ParseCLI(4, bad), "bad values fail again");
+    Check(allocations == before, "rejecting arguments doesn't allocate");
+    Check(parser.Error() == "Flag 'number' received an invalid value",
+        "errors render on request");
+
+    const char *const positional[] = {"prog", "x"};
+    Check(!parser.ParseCLI(2, positional) &&
+            parser.LastError().Target() == &name &&
+            parser.Error() == "Positional 'NAME' received an invalid value",
+        "positional errors name their positional");
+    Check(parser.Error("custom").Error() == "custom" &&
+            parser.LastError().Code() == Parser::ErrorCode::Custom,
+        "custom errors replace the message");
+}
+
+// Splits a value at commas into a fresh list, then moves it into place
+static bool SplitCommas(const argsplus::ArgumentParser<>::StringView &value,
+    std::vector<std::string> &out) {
+    std::vector<std::string> fields(1);
+    for (const char c : value) {
+        if (c == ',') {
+            fields.emplace_back();
+        } else {
+            fields.back().push_back(c);
+        }
+    }
+    out = std::move(fields);
+    return true;
+}
+
+// Heavy values are moved in as defaults, converted by a hook, and moved out
+static void TestMoveValues() {
+    using Parser = argsplus::ArgumentParser<>;
+    Parser parser;
+    auto &paths = parser.AddOption<std::vector<std::string>>("PATHS", {"path"})
+                      .Convert(&SplitCommas);
+    auto &name = parser.AddOption<std::string>("NAME", {"name"})
+                     .EmplaceDefault(3, 'x');
+    Check(name.Value() == "xxx", "defaults are constructed from arguments");
+
+    std::vector<std::string> defaults(100, "some-default-path");
+    std::size_t before = allocations;
+    paths.Default(std::move(defaults));
+    // The vector and its strings are copied once, into the current value
+    Check(allocations - before == 101, "moved defaults are copied only once");
+
+    const std::vector<std::string> args{"--path=a,b,c", "--name=abc"};
+    Check(parser.ParseArgs(args) &&
+            paths.Value() == std::vector<std::string>{"a", "b", "c"},
+        "converters replace extraction");
+    before = allocations;
+    const std::vector<std::string> taken = paths.TakeValue();
+    const std::string takenName = name.TakeValue();
+    Check(allocations == before && taken.size() == 3 && takenName == "abc",
+        "values are moved out without copies");
+
+    Parser::Result result(parser);
+    Check(parser.ParseArgs(args, result) &&
+            result.TakeValue(paths).size() == 3 &&
+            result.Value(paths).empty(),
+        "values are moved out of a Result");
+    Check(parser.ParseArgs(args, result) && result.Value(paths).size() == 3,
+        "the next parse restores a taken value");
+}
+
+// A domain type without a stream extraction operator
+struct Address {
+    unsigned char octets[4];
+};
+
+static bool ParseAddress(
+    const argsplus::ArgumentParser<>::StringView &value, Address &out) {
+    std::size_t octet = 0;
+    unsigned part = 0;
+    bool digits = false;
+    for (const char c : value) {
+        if (c >= '0' && c <= '9') {
+            part = part * 10 + (c - '0');
+            if (part > 255) {
+                return false;
+            }
+            digits = true;
+        } else if (c == '.' && digits && octet < 3) {
+            out.octets[octet++] = static_cast<unsigned char>(part);
+            part = 0;
+            digits = false;
+        } else {
+            return false;
+        }
+    }
+    if (!digits || octet != 3) {
+        return false;
+    }
+    out.octets[3] = static_cast<unsigned char>(part);
+    return true;
+}
+
+// Converters see a view of the raw characters, may capture, and are called
+// without allocating
+static void TestConverters() {
+    using Parser = argsplus::ArgumentParser<>;
+    Parser parser;
+    const auto &address =
+        parser.AddOption<Address>("ADDRESS", {'a'}, &ParseAddress);
+    const unsigned scale = 60;
+    const auto &minutes = parser.AddPositional<unsigned>("MINUTES").Convert(
+        [scale](const Parser::StringView &value, unsigned &out) {
+            if (value.empty() || value[value.size() - 1] != 'm') {
+                return false;
+            }
+            out = 0;
+            for (const char c : value.substr(0, value.size() - 1)) {
+                if (c < '0' || c > '9') {
+                    return false;
+                }
+                out = out * 10 + (c - '0');
+            }
+            out *= scale;
+            return true;
+        });
+    parser.Freeze();
+
+    const char *const args[] = {"prog", "-a", "10.0.255.1", "90m"};
+    const std::size_t before = allocations;
+    Check(parser.ParseCLI(4, args), "converted values parse");
+    Check(allocations == before, "converters don't allocate");
+    Check(address.Value().octets[0] == 10 &&
+            address.Value().octets[2] == 255 && minutes.Value() == 5400,
+        "converters produce their values");
+
+    const char *const bad[] = {"prog", "-a", "10.0.256.1"};
+    Check(!parser.ParseCLI(3, bad) &&
+            parser.LastError().Code() == Parser::ErrorCode::InvalidValue,
+        "converters reject invalid values");
+
+    // Types that can't be read from a stream only compile with a Converter,
+    // so only clearing it leaves them with none
+    const auto hostConverter = [](const Parser::StringView &value,
+                                   std::vector<Address> &out) {
+        Address address = Address();
+        out.push_back(address);
+        return ParseAddress(value, out.back());
+    };
+    Parser forgotten;
+    auto &hosts = forgotten.AddOption<std::vector<Address>>(
+        "HOSTS", {'h'}, hostConverter);
+    hosts.Convert(nullptr);
+    forgotten.Freeze();
+    const char *const host[] = {"prog", "-h", "10.0.0.1"};
+    Parser::Result result(forgotten);
+    Check(!forgotten.ParseCLI(3, host) &&
+            forgotten.Error() ==
+                "'HOSTS' has no Converter, and its type can't be read from "
+                "a stream" &&
+            !forgotten.ParseCLI(3, host, result) &&
+            result.LastError().Code() == Parser::ErrorCode::Schema,
+        "types that can't be read need a Converter before any parse");
+    hosts.Convert(hostConverter);
+    Check(forgotten.ParseCLI(3, host) && hosts.Value().size() == 1,
+        "and parse once they have one again");
+
+    std::vector<unsigned char> blob;
+    Parser loaded;
+    Check(forgotten.SaveSchema(blob) &&
+            loaded.LoadSchema(blob.data(), blob.size()),
+        "schemas of converted nodes load");
+    auto *const bound =
+        loaded.BindOption<std::vector<Address>>("HOSTS", hostConverter);
+    Check(bound && loaded.ParseCLI(3, host) && bound->Value().size() == 1 &&
+            bound->Value()[0].octets[0] == 10,
+        "and bind with their Converter");
+}
+
+// Delimited list values are split into elements, each converted alone
+static void TestDelimitedLists() {
+    using Parser = argsplus::ArgumentParser<>;
+    Parser parser;
+    const auto &hosts =
+        parser.AddOption<std::vector<std::string>>("HOSTS", {"hosts"})
+            .Delimiter(',');
+    const auto &ports =
+        parser.AddOption<std::vector<int>>("PORTS", {'p'}).Delimiter(':');
+    parser.Freeze();
+
+    std::string many = "--hosts=";
+    for (int i = 0; i < 1000; ++i) {
+        many += (i ? ",host-" : "host-") + std::to_string(i);
+    }
+    const std::vector<std::string> args{many, "-p80:443", "--hosts=last"};
+    Check(parser.ParseArgs(args), "delimited lists parse");
+    Check(hosts.Value().size() == 1001 && hosts.Value()[999] == "host-999" &&
+            hosts.Value().back() == "last",
+        "delimited values append every element");
+    Check(ports.Value() == std::vector<int>{80, 443},
+        "elements use the numeric conversions");
+
+    const std::vector<std::string> bad{"-p1:2", "-p3:x:4"};
+    Check(!parser.ParseArgs(bad) && ports.Value() == std::vector<int>{1, 2},
+        "an invalid element leaves the list as it was");
+}
+
+// Frozen parsers keep matches in a bitset that the handles still read
+static void TestMatchedBits() {
+    using Parser = argsplus::ArgumentParser<>;
+    Parser parser;
+    const auto &first = parser.AddOption<int>("OPTION", {"option-0"});
+    std::vector<decltype(&first)> options{&first};
+    for (int i = 1; i < 200; ++i) {
+        options.push_back(
+            &parser.AddOption<int>("OPTION", {"option-" + std::to_string(i)}));
+    }
+    auto &rest = parser.AddPositional<std::vector<int>>("REST");
+    rest.Matched(true);
+    parser.Freeze();
+    Check(rest.Matched(), "matches made before freezing are kept");
+
+    const std::vector<std::string> args{"--option-3=3", "--option-130=130"};
+    Check(parser.ParseArgs(args), "frozen parsers parse");
+    Check(options[3]->Matched() && options[130]->Matched() &&
+            !options[4]->Matched() && !options[199]->Matched() &&
+            !rest.Matched(),
+        "handles read the matched bitset");
+    rest.Matched(true);
+    Check(rest.Matched() && !options[199]->Matched(),
+        "handles write the matched bitset");
+    parser.Reset();
+    Check(!rest.Matched() && !options[3]->Matched(),
+        "resets clear the matched bitset");
+}
+
+// Validating with threads gives exactly the values and the error of
+// validating without them
+static void TestParallelValidate() {
+    std::vector<std::string> args;
+    for (int i = 0; i < 10000; ++i) {
+        args.push_back(std::to_string(i));
+    }
+    args[7000] = "bad";
+    args[9000] = "worse";
+    args.push_back("--sizes=1,x");
+    for (const unsigned threads : {1u, 4u}) {
+        argsplus::ArgumentParser<> parser;
+        parser.Lazy(true);
+        const auto &ids = parser.AddPositional<std::vector<int>>("IDS");
+        const auto &sizes =
+            parser.AddOption<std::vector<int>>("SIZES", {"sizes"})
+                .Delimiter(',');
+        Check(parser.ParseArgs(args), "long lazy lists parse");
+        Check(!parser.Validate(threads) &&
+                parser.LastError().Index() == 7000 &&
+                parser.Error() == "Positional 'IDS' received an invalid value",
+            "the earliest invalid value is reported with any threads");
+        Check(ids.Value().size() == 7000 && ids.Value()[6999] == 6999 &&
+                sizes.Value().empty(),
+            "values stop at their first invalid value with any threads");
+
+        parser.Reset();
+        args[7000] = "7000";
+        args[9000] = "9000";
+        args.back() = "--sizes=1,2";
+        Check(parser.ParseArgs(args) && parser.Validate(threads) &&
+                ids.Value().size() == 10000 && ids.Value()[9000] == 9000 &&
+                sizes.Value().size() == 2,
+            "valid lists are joined in order");
+        args[7000] = "bad";
+        args[9000] = "worse";
+        args.back() = "--sizes=1,x";
+    }
+}
+
+// Subcommands are dispatched on their word, and only the selected ones are
+// ever built
+static void TestCommands() {
+    using Parser = argsplus::ArgumentParser<>;
+    Parser parser;
+    const auto &verbose = parser.AddOption<int>("VERBOSE", {'v'});
+    int built = 0;
+    for (int i = 0; i < 80; ++i) {
+        parser.AddCommand("command-" + std::to_string(i),
+            [&built](Parser &command) {
+                ++built;
+                command.AddOption<int>("COUNT", {'c', "count"});
+                command.AddPositional<std::vector<std::string>>("FILES");
+            });
+    }
+    decltype(&verbose) status = nullptr;
+    parser.AddCommand("status", [&](Parser &command) {
+        ++built;
+        status = &command.AddOption<int>("LIMIT", {"limit"});
+    });
+    parser.Freeze();
+
+    const std::vector<std::string> args{"-v", "1", "status", "--limit=5"};
+    Check(parser.ParseArgs(args) && built == 1, "only the selected is built");
+    Check(verbose.Value() == 1 && status && status->Value() == 5 &&
+            parser.Selected() && parser.Selected()->Prog() == "status",
+        "options before and after the subcommand word both parse");
+
+    const std::vector<std::string> bad{"status", "--limit=x", "more"};
+    auto stop = bad.begin();
+    Check(!parser.ParseArgs(bad.begin(), bad.end(), stop) &&
+            stop == bad.begin() + 1 && parser.LastError().Index() == 1 &&
+            parser.Error() == "Flag 'limit' received an invalid value",
+        "subcommand errors stop at their argument");
+
+    Check(parser.ParseCommand("-v 2 command-7 -c 3 a b") && built == 2 &&
+            parser.Selected() == parser.Command("command-7") &&
+            !parser.Command("missing"),
+        "command strings dispatch too");
+    const std::vector<std::string> terminated{"--", "status"};
+    Check(!parser.ParseArgs(terminated) && !parser.Selected(),
+        "words after the terminator are never subcommands");
+    Parser::Result result(parser);
+    Check(!parser.ParseArgs(args, result) &&
+            result.LastError().Code() == Parser::ErrorCode::Schema &&
+            result.Error() ==
+                "subcommands are not supported when parsing into a Result",
+        "results refuse parsers with subcommands");
+    Parser::Batch batch(parser);
+    Check(!parser.ParseBatch(std::vector<std::vector<std::string>>{args},
+              batch) &&
+            batch.Error() ==
+                "subcommands are not supported when parsing into a Batch",
+        "batches refuse parsers with subcommands");
+
+    Parser duplicate;
+    duplicate.AddCommand("run", [](Parser &) {});
+    duplicate.AddCommand("run", [](Parser &) {});
+    Check(!duplicate.ParseArgs(args) &&
+            duplicate.Error() == "Command 'run' was registered more than once",
+        "duplicate subcommands are schema errors");
+}
+
+// Help is rendered once, wrapped to its width, and again only after the
+// parser or one of its nodes changes
+static void TestHelp() {
+    using Parser = argsplus::ArgumentParser<>;
+    Parser parser("Copies files from one place to another", "See also: mv",
+        "cp");
+    parser.HelpWidth(40);
+    parser.AddOption<int>("COUNT", {'c', "count"})
+        .Help("How many times to copy every file, which is once by default");
+    auto &files = parser.AddPositional<std::vector<std::string>>("FILES");
+    parser.AddCommand("status", [](Parser &) {}, "Show the status");
+    parser.Freeze();
+
+    Check(parser.Help() ==
+            "Usage: cp [OPTIONS] [FILES...] COMMAND\n"
+            "\n"
+            "Copies files from one place to another\n"
+            "\n"
+            "Options:\n"
+            "  -c, --count COUNT\n"
+            "                    How many times to\n"
+            "                    copy every file,\n"
+            "                    which is once by\n"
+            "                    default\n"
+            "\n"
+            "Positionals:\n"
+            "  FILES\n"
+            "\n"
+            "Commands:\n"
+            "  status  Show the status\n"
+            "\n"
+            "See also: mv\n",
+        "help lists every node, wrapped to its width");
+    Check(parser.Usage() == "Usage: cp [OPTIONS] [FILES...] COMMAND",
+        "the usage is the first line of the help");
+
+    const std::size_t before = allocations;
+    const char *const cached = parser.Help().data();
+    char buffer[9];
+    const std::size_t size = parser.WriteHelp(buffer, sizeof(buffer));
+    Check(allocations == before && parser.Help().data() == cached,
+        "help is only rendered once");
+    Check(size == parser.Help().size() &&
+            std::string(buffer, sizeof(buffer)) == "Usage: cp",
+        "help is copied into buffers");
+
+    files.Help("The files to copy");
+    Check(parser.Help().find("  FILES  The files to copy\n") !=
+            std::string::npos,
+        "changing a node renders the help again");
+}
+
+// Completion walks the flag indices from the partial word, and works out
+// what it is from the arguments before it
+static void TestCompletion() {
+    using Parser = argsplus::ArgumentParser<>;
+    Parser parser;
+    for (int i = 0; i < 1200; ++i) {
+        parser.AddOption<int>("OPTION", {"opt-" + std::to_string(i)});
+    }
+    const auto &count = parser.AddOption<int>("COUNT", {'c', "count"});
+    const auto &first = parser.AddPositional<std::string>("FIRST");
+    const auto &rest = parser.AddPositional<std::vector<std::string>>("REST");
+    parser.AddCommand("start", [](Parser &command) {
+        command.AddOption<int>("DELAY", {'d', "delay"});
+    });
+    parser.AddCommand("stop", [](Parser &) {});
+    parser.Freeze();
+
+    Parser::Completion completion;
+    const std::vector<std::string> none;
+    parser.Complete(none, "--opt-11", completion);
+    Check(completion.longFlags.size() == 111 &&
+            completion.longFlags[0] == "opt-11" &&
+            completion.longFlags[1] == "opt-110" &&
+            completion.longFlags[2] == "opt-1100" && !completion.positional,
+        "long flags complete from the flag index, sorted");
+
+    const std::size_t before = allocations;
+    parser.Complete(none, "--opt-12", completion);
+    Check(allocations == before && completion.longFlags.size() == 11,
+        "a reused completion doesn't allocate");
+
+    parser.Complete(none, "-", completion);
+    Check(completion.longFlags.size() == 1201 &&
+            completion.shortFlags == std::vector<char>{'c'},
+        "a bare prefix completes to every flag");
+
+    const std::vector<std::string> flag{"--count"};
+    parser.Complete(flag, "", completion);
+    Check(completion.option == &count && completion.longFlags.empty(),
+        "a word after a value flag is its value");
+    parser.Complete(none, "--count=1", completion);
+    Check(completion.option == &count, "joined values are values");
+
+    parser.Complete(none, "st", completion);
+    Check(!completion.option && completion.positional == &first &&
+            completion.commands.size() == 2 &&
+            completion.commands[0] == "start",
+        "positional words complete to subcommands");
+    const std::vector<std::string> positionals{"-c", "1", "a", "b"};
+    parser.Complete(positionals, "", completion);
+    Check(completion.positional == &rest, "list positionals take the rest");
+
+    const std::vector<std::string> command{"a", "start"};
+    parser.Complete(command, "--d", completion);
+    Check(completion.parser == parser.Command("start") &&
+            completion.longFlags.size() == 1 &&
+            completion.longFlags[0] == "delay",
+        "subcommands complete their own flags");
+}
+
+// A frozen schema saves to a blob that loads into a new parser without
+// building its nodes again, whose typed handles are bound by name
+static void TestSchema() {
+    using Parser = argsplus::ArgumentParser<>;
+    Parser original("Copies files", "", "cp");
+    for (int i = 0; i < 1000; ++i) {
+        original.AddOption<int>("OPTION", {"opt-" + std::to_string(i)});
+    }
+    auto &originalCount = original.AddOption<int>("COUNT", {'c', "count"})
+                              .Help("How many copies");
+    original.AddOption<std::vector<std::string>>("INCLUDE", {'I'});
+    auto &originalFiles =
+        original.AddPositional<std::vector<std::string>>("FILES");
+    original.Abbreviations(true).LongPrefix("++").Freeze();
+    std::vector<unsigned char> blob;
+    Check(original.SaveSchema(blob), "frozen parsers save their schema");
+
+    Parser loaded;
+    std::size_t before = allocations;
+    const bool load = loaded.LoadSchema(blob.data(), blob.size());
+    Check(load && allocations - before < 16 && loaded.Frozen(),
+        "loading a schema allocates a few buffers, not one per node");
+    const std::vector<std::string> args{
+        "++cou=3", "-Ia", "-I", "b", "x", "++opt-999", "9"};
+    Check(!loaded.ParseArgs(args) &&
+            loaded.Error() ==
+                "Every option and positional of a loaded schema must be bound",
+        "parses fail until every node is bound");
+
+    before = allocations;
+    auto *count = loaded.BindOption<int>("COUNT");
+    Check(!loaded.BindOption<std::string>("INCLUDE") &&
+            !loaded.BindOption<int>("MISSING") &&
+            !loaded.BindOption<int>("COUNT"),
+        "nodes are bound once, to a type of the same kind");
+    auto *const include =
+        loaded.BindOption<std::vector<std::string>>("INCLUDE");
+    auto *const files =
+        loaded.BindPositional<std::vector<std::string>>("FILES");
+    decltype(count) last = nullptr;
+    for (int i = 0; i < 1000; ++i) {
+        last = loaded.BindOption<int>("OPTION");
+    }
+    Check(count && include && files && last &&
+            allocations - before < 100,
+        "binding allocates only arena blocks");
+
+    Check(loaded.ParseArgs(args) && count->Value() == 3 &&
+            include->Value() == std::vector<std::string>{"a", "b"} &&
+            files->Value() == std::vector<std::string>{"x"} &&
+            last->Value() == 9,
+        "a loaded schema parses with its saved settings and flags");
+    Check(loaded.Help() == original.Help(), "the help is saved too");
+
+    // Until something in it changes, when it's rendered again from the schema
+    Parser unbound;
+    Check(unbound.LoadSchema(blob.data(), blob.size()), "schemas load again");
+    original.HelpWidth(30);
+    unbound.HelpWidth(30);
+    Check(unbound.Help() == original.Help() &&
+            unbound.Help().find("-c, ++count COUNT") != std::string::npos,
+        "the help of a loaded schema follows its help width");
+    loaded.HelpWidth(30);
+    count->Help("How many copies to make of every file");
+    originalCount.Help("How many copies to make of every file");
+    files->Help("The files to copy");
+    originalFiles.Help("The files to copy");
+    Check(loaded.Help() == original.Help() &&
+            loaded.Help().find("The files to copy") != std::string::npos,
+        "and the help of its bound nodes");
+    Parser::Result result(loaded);
+    Check(loaded.ParseArgs(args, result) && result.Value(*count) == 3,
+        "loaded schemas parse into Results");
+
+    Parser other;
+    blob[blob.size() / 2] ^= 1;
+    Check(!other.LoadSchema(blob.data(), blob.size()) &&
+            other.Error() ==
+                "The schema blob is not one that this parser can load",
+        "damaged blobs never load");
+    Check(!other.LoadSchema(blob.data(), 3), "nor do truncated ones");
+}
+
+// Joined and separate values may each be turned off for short and long
+// flags
+static void TestValueSyntax() {
+    using Parser = argsplus::ArgumentParser<>;
+    Parser parser;
+    const auto &count = parser.AddOption<int>("COUNT", {'c', "count"});
+    parser.JoinedShort(false).SeparateLong(false).Freeze();
+    const std::vector<std::string> joinedShort{"-c3"};
+    const std::vector<std::string> separateLong{"--count", "3"};
+    const std::vector<std::string> allowed{"-c", "3", "--count=4"};
+    Check(!parser.ParseArgs(joinedShort) &&
+            parser.LastError().Code() == Parser::ErrorCode::JoinedArgument,
+        "short flags may refuse joined values");
+    Check(!parser.ParseArgs(separateLong) &&
+            parser.LastError().Code() == Parser::ErrorCode::SeparateArgument,
+        "long flags may refuse separate values");
+    Check(parser.ParseArgs(allowed) && count.Value() == 4 &&
+            !parser.JoinedShort() && parser.JoinedLong(),
+        "the other forms are still taken");
+}
+
+struct alignas(64) Wide {
+    int value;
+};
+
+static std::istream &operator>>(std::istream &is, Wide &wide) {
+    return is >> wide.value;
+}
+
+// Results place over-aligned values at addresses aligned for them, though
+// their buffers are only aligned for std::max_align_t
+static void TestAlignedSlots() {
+    argsplus::ArgumentParser<> parser;
+    parser.AddOption<std::string>("NAME", {'n'});
+    const auto &wide = parser.AddOption<Wide>("WIDE", {'w'});
+    parser.Freeze();
+
+    const std::vector<std::string> args{"-n", "name", "-w", "7"};
+    bool aligned = true;
+    std::vector<std::unique_ptr<argsplus::ArgumentParser<>::Result>> results;
+    for (int i = 0; i < 8; ++i) {
+        results.emplace_back(new argsplus::ArgumentParser<>::Result(parser));
+        const Wide &value = results.back()->Value(wide);
+        aligned = aligned &&
+            reinterpret_cast<std::uintptr_t>(&value) % alignof(Wide) == 0 &&
+            parser.ParseArgs(args, *results.back()) && value.value == 7;
+    }
+    Check(aligned, "over-aligned values are aligned in a Result");
+}
+
+// Every short and long flag of every option resolves with one lookup in the
+// parser-wide flag index, however many options there are, and a flag that
+// two options share is caught when the second one is registered
+static void TestFlagIndex() {
+    using Parser = argsplus::ArgumentParser<>;
+    Parser::Stats stats;
+    Parser parser;
+    parser.Instrument(&stats);
+    using Option = std::remove_reference<decltype(
+        parser.AddOption<int>("", {"flag"}))>::type;
+    std::vector<const Option *> options;
+    for (int i = 0; i < 300; ++i) {
+        const std::string number = std::to_string(i);
+        options.push_back(&parser.AddOption<int>("OPTION" + number,
+            {"option-" + number, "alias-" + number}));
+    }
+    const auto &first = parser.AddOption<int>("FIRST", {'a', "first"});
+    const auto &last = parser.AddOption<int>("LAST", {'z', "last"});
+
+    stats.Clear();
+    const std::vector<std::string> args{"--option-0=1", "--alias-299", "2",
+        "--option-150=3", "-a4", "-z", "5", "--first=6"};
+    Check(parser.ParseArgs(args) && options[0]->Value() == 1 &&
+            options[299]->Value() == 2 && options[150]->Value() == 3 &&
+            first.Value() == 6 && last.Value() == 5,
+        "long flags, their aliases and short flags resolve to their option");
+    Check(stats.lookups == 6, "each flag is a single lookup");
+    const std::vector<std::string> prefix{"--option-"};
+    Check(!parser.ParseArgs(prefix) &&
+            parser.Error() == "Flag could not be matched: option-",
+        "prefixes of indexed flags don't match without abbreviations");
+
+    Parser longDuplicate;
+    longDuplicate.AddOption<int>("FIRST", {'f', "flag"});
+    const std::vector<std::string> none;
+    Check(longDuplicate.ParseArgs(none), "distinct flags are accepted");
+    longDuplicate.AddOption<int>("SECOND", {'s', "flag"});
+    Check(!longDuplicate.ParseArgs(none) &&
+            longDuplicate.Error() ==
+                "Flag 'flag' was registered to more than one option",
+        "duplicate long flags are rejected as they are registered");
+
+    Parser shortDuplicate;
+    shortDuplicate.AddOption<int>("FIRST", {'f', "first"});
+    shortDuplicate.AddOption<int>("SECOND", {'f', "second"});
+    Check(!shortDuplicate.ParseArgs(none) &&
+            shortDuplicate.Error() ==
+                "Flag 'f' was registered to more than one option",
+        "duplicate short flags are rejected as they are registered");
+}
+
+// A value that keeps the view it was parsed from, to show where it points
+struct Span {
+    const char *data;
+    std::size_t size;
+};
+
+static bool ParseSpan(
+    const argsplus::ArgumentParser<>::StringView &value, Span &out) {
+    out.data = value.data();
+    out.size = value.size();
+    return true;
+}
+
+// Chunks are split into views of the arguments themselves, from the prefix
+// to the value, so that values reach their parser without being copied
+static void TestViews() {
+    using Parser = argsplus::ArgumentParser<>;
+    Parser parser;
+    const auto &joined =
+        parser.AddOption<Span>("JOINED", {"joined"}, &ParseSpan);
+    const auto &separate =
+        parser.AddOption<Span>("SEPARATE", {"separate"}, &ParseSpan);
+    const auto &shortJoined =
+        parser.AddOption<Span>("SHORT", {'s'}, &ParseSpan);
+    const auto &positional =
+        parser.AddPositional<Span>("POSITIONAL", &ParseSpan);
+    parser.Freeze();
+
+    const char *const argv[] = {"prog", "--joined=first", "--separate",
+        "second", "-sthird", "fourth"};
+    const auto within = [](const Span &span, const char *arg) {
+        return span.data >= arg &&
+            span.data + span.size == arg + std::strlen(arg);
+    };
+    const std::size_t before = allocations;
+    Check(parser.ParseCLI(6, argv), "views of argv parse");
+    Check(allocations == before, "views of argv don't allocate");
+    Check(within(joined.Value(), argv[1]) && joined.Value().size == 5 &&
+            separate.Value().data == argv[3] &&
+            within(shortJoined.Value(), argv[4]) &&
+            shortJoined.Value().size == 5 &&
+            positional.Value().data == argv[5],
+        "long, short, joined and separate values view their argument");
+
+    const std::vector<std::string> args{"--joined", "a-rather-long-value"};
+    Check(parser.ParseArgs(args) &&
+            joined.Value().data == args[1].data() &&
+            joined.Value().size == args[1].size(),
+        "ParseArgs views the strings of its List");
+}
+
+// Every kind of node reaches its Root and ValueRoot through the interfaces
+// resolved when it was registered or bound.  The Makefile also builds these
+// tests with -fno-rtti, which only builds if nothing needs a dynamic_cast.
+static void TestNodeInterfaces() {
+    using Parser = argsplus::ArgumentParser<>;
+    Parser parser;
+    const auto &scalar = parser.AddOption<int>("SCALAR", {'s'});
+    const auto &list = parser.AddOption<std::vector<int>>("LIST", {'l'});
+    const auto &first = parser.AddPositional<std::string>("FIRST");
+    const auto &rest = parser.AddPositional<std::vector<int>>("REST");
+    parser.Freeze();
+
+    const std::vector<std::string> args{"-s1", "-l2", "word", "-l3", "4"};
+    Check(parser.ParseArgs(args) && scalar.Matched() && scalar.Value() == 1 &&
+            list.Value() == std::vector<int>{2, 3} && first.Value() == "word" &&
+            rest.Value() == std::vector<int>{4},
+        "options and positionals parse through their interfaces");
+    Parser::Result result(parser);
+    Check(parser.ParseArgs(args, result) && result.Value(scalar) == 1 &&
+            result.Value(rest) == std::vector<int>{4},
+        "and so do Results");
+    const std::vector<std::string> invalid{"x", "y"};
+    Check(!parser.ParseArgs(invalid) &&
+            parser.Error() == "Positional 'REST' received an invalid value",
+        "errors name their node through its Root");
+
+    std::vector<unsigned char> blob;
+    Parser loaded;
+    Check(parser.SaveSchema(blob) &&
+            loaded.LoadSchema(blob.data(), blob.size()),
+        "the schema loads");
+    auto *const bound = loaded.BindOption<int>("SCALAR");
+    loaded.BindOption<std::vector<int>>("LIST");
+    loaded.BindPositional<std::string>("FIRST");
+    auto *const boundRest = loaded.BindPositional<std::vector<int>>("REST");
+    Check(loaded.ParseArgs(args) && bound->Value() == 1 &&
+            boundRest->Value() == std::vector<int>{4},
+        "bound nodes parse through their interfaces");
+}
+
+// Attached Stats count each phase of the parses through their parser or
+// Result, and add up until they are cleared
+static void TestInstrumentation() {
+    using Parser = argsplus::ArgumentParser<>;
+    Parser::Stats stats;
+    Parser parser;
+    parser.Instrument(&stats);
+    parser.AddOption<int>("NUMBER", {'n', "number"});
+    parser.AddPositional<std::vector<int>>("REST");
+    parser.Freeze();
+    Check(stats.bytes > 0, "nodes are counted as they are allocated");
+
+    stats.Clear();
+    const std::vector<std::string> args{"--number=1", "-n", "2", "3", "4"};
+    Check(parser.ParseArgs(args), "instrumented parses succeed");
+    Check(stats.chunks == 4 && stats.lookups == 2 &&
+            stats.conversions == 4 && stats.positionals == 2 &&
+            stats.errors == 0 && stats.bytes == 0,
+        "every phase of a parse is counted");
+
+    const std::vector<std::string> bad{"--nope"};
+    Check(!parser.ParseArgs(bad) && stats.chunks == 5 &&
+            stats.lookups == 3 && stats.errors == 1,
+        "counters add up across parses, errors included");
+
+    Parser::Stats resultStats;
+    Parser::Result result(parser);
+    result.Instrument(&resultStats);
+    Check(parser.ParseArgs(args, result) && resultStats.conversions == 4 &&
+            stats.conversions == 4,
+        "parses into a Result are counted in its own Stats");
+}
+
+using Parser = argsplus::ArgumentParser<>;
+constexpr Parser::FixedOption fixedSpec[] = {{"DOUBLE", {'d', "double"}},
+    {"COUNT", {"count", 'c'}}, {"FIRST"}, {"REST"}};
+static_assert(Parser::FixedUnique(fixedSpec), "fixed flags are unique");
+constexpr Parser::FixedOption duplicateSpec[] = {{"A", {'a', "all"}},
+    {"B", {'b', "all"}}};
+static_assert(!Parser::FixedUnique(duplicateSpec), "duplicates are found");
+const Parser::FixedOption twoShortSpec[] = {{"A", {'a', 'b'}}};
+
+static void TestFixedParser() {
+    using Fixed = Parser::FixedParser<fixedSpec, double, int, std::string,
+        std::vector<int>>;
+    Fixed parser;
+    const char *const argv[] = {"prog", "--double=2.5", "first", "-c", "3",
+        "4", "--", "-5"};
+    Check(parser.ParseCLI(sizeof(argv) / sizeof(*argv), argv),
+        "fixed parser parses");
+    Check(parser.Value<0>() == 2.5 && parser.Value<1>() == 3,
+        "fixed parser assigns flag values");
+    Check(parser.Value<2>() == "first", "fixed parser assigns positionals");
+    Check(parser.Value<3>() == std::vector<int>({4, -5}),
+        "fixed parser fills a list positional");
+    const std::vector<std::string> again{"-d", "1", "second"};
+    Check(parser.ParseArgs(again) && parser.Value<0>() == 1 &&
+            parser.Value<1>() == 0 && !parser.Matched(1) &&
+            parser.Value<2>() == "second" && parser.Value<3>().empty(),
+        "fixed parser starts each parse afresh");
+    parser.Default<1>(7);
+    Check(parser.Value<1>() == 7 && parser.ParseArgs(again) &&
+            parser.Value<1>() == 7 && !parser.Matched(1),
+        "fixed parser restores defaults");
+    const std::vector<std::string> joined{"--count=2", "-d2"};
+    Check(parser.ParseArgs(joined) && parser.Value<1>() == 2 &&
+            parser.Value<0>() == 2 && parser.Default<1>() == 7,
+        "fixed parser matches joined values");
+
+    Fixed failing;
+    const std::vector<std::string> args{"-x"};
+    Check(!failing.ParseArgs(args) &&
+            failing.Error() == "Flag could not be matched: x",
+        "fixed parser reports unmatched flags");
+    const std::vector<std::string> prefix{"--doubles", "1"};
+    Check(!failing.ParseArgs(prefix) &&
+            failing.Error() == "Flag could not be matched: doubles",
+        "fixed parser compares the hashed long flag");
+    Parser::FixedParser<duplicateSpec, int, int> duplicate;
+    Check(!duplicate.ParseArgs(std::vector<std::string>()) &&
+            duplicate.Error() ==
+                "Flag 'all' was registered to more than one option",
+        "fixed parser refuses duplicate flags");
+    Check(!Parser::FixedUnique(twoShortSpec),
+        "fixed matchers take one flag of each kind");
+}
+
 int main(int argc, char **argv) {
+    TestParseCLIAllocations();
+    TestParserAllocations();
+    TestNumericStrictness();
+    TestFlagIndex();
+    TestViews();
+    TestNodeInterfaces();
+    TestListPositional();
+    TestFrozenReuse();
+    TestSharedResults();
+    TestFixedParser();
+    TestLazyValues();
+    TestBatch();
+    TestResponseFiles();
+    TestParseCommand();
+    TestCustomSyntax();
+    TestLongFlags();
+    TestShortFlags();
+    TestStructuredErrors();
+    TestInstrumentation();
+    TestMoveValues();
+    TestConverters();
+    TestDelimitedLists();
+    TestMatchedBits();
+    TestParallelValidate();
+    TestCommands();
+    TestHelp();
+    TestCompletion();
+    TestSchema();
+    TestValueSyntax();
+    TestAlignedSlots();
+    if (failures) {
+        return 1;
+    }
+
     argsplus::ArgumentParser<> parser(
         "This is a test program", "This is the big epilogue");
     const auto &doubleflag = parser.AddOption<double>("DUBFLAG", {'d', "double"})